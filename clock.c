@@ -0,0 +1,114 @@
+#include "defs.h"
+
+/*
+    Virtual time runs the game as a discrete event simulation. Threads still act concurrently, but
+    instead of sleeping for real they wait until every thread of the game is waiting, then the clock
+    jumps straight to the earliest wake up time. The hunter and ghost cadences keep their ratio while
+    the game runs as fast as the work allows.
+*/
+
+/*  Function: clockAdvance()
+    Description: Moves the clock to the earliest wake up time once every thread is waiting and wakes
+                 the threads that are due. Must be called with clockLock held.
+
+    in/out: GameStateType *game - Pointer to the game whose clock to advance
+
+    Returns: None
+*/
+static void clockAdvance(GameStateType *game) {
+    if (game->clockSleeping == 0 || game->clockSleeping < game->clockThreads) return; // Someone is still acting
+
+    long long next = game->clockWake[0];
+    for(int i = 1; i < game->clockSleeping; i++) {
+        if(game->clockWake[i] < next) next = game->clockWake[i];
+    }
+    __atomic_store_n(&game->clockNow, next, __ATOMIC_RELAXED);
+
+    // The due threads are taken off the list here so a thread that starts waiting before they
+    // get to run again can not advance the clock past them
+    for(int i = 0; i < game->clockSleeping; ) {
+        if(game->clockWake[i] <= next) {
+            game->clockWake[i] = game->clockWake[--game->clockSleeping];
+        } else {
+            i++;
+        }
+    }
+    pthread_cond_broadcast(&game->clockCond);
+}
+
+/*  Function: gameClockStart()
+    Description: Resets the clock for the threads that are about to be started, must be called before any of them run
+
+    in/out: GameStateType *game - Pointer to the game the threads belong to
+    in: int threads - How many threads will call simSleep()
+
+    Returns: None
+*/
+void gameClockStart(GameStateType *game, int threads) {
+    if (!game) return; // Check for NULL pointer
+    free(game->clockWake);
+    game->clockWake = safeMalloc(sizeof(long long) * (threads > 0 ? threads : 1));
+    game->clockNow = 0;
+    game->clockThreads = threads;
+    game->clockSleeping = 0;
+    game->startTime = 0;
+    game->startTime = gameTime(game);
+}
+
+/*  Function: simSleep()
+    Description: Waits for the given time, in virtual time only until the clock reaches it
+
+    in/out: GameStateType *game - Pointer to the game the calling thread belongs to
+    in: int usec - How long to wait in microseconds
+
+    Returns: None
+*/
+void simSleep(GameStateType *game, int usec) {
+    if (!game || !game->virtualTime) {
+        usleep(usec);
+        return;
+    }
+
+    // A wait of 0 would be due before anyone advanced the clock and never be taken off the list,
+    // so it waits for the next tick and lets every other thread act first
+    if(usec < 1) usec = 1;
+
+    pthread_mutex_lock(&game->clockLock);
+    long long wake = game->clockNow + usec;
+    game->clockWake[game->clockSleeping++] = wake;
+    clockAdvance(game);
+    while(game->clockNow < wake) pthread_cond_wait(&game->clockCond, &game->clockLock);
+    pthread_mutex_unlock(&game->clockLock);
+}
+
+/*  Function: gameTime()
+    Description: The time since the game's threads were started in microseconds, the virtual
+                 clock in virtual time and the monotonic clock otherwise
+
+    in: GameStateType *game - Pointer to the game to read the time of
+
+    Returns: long long - The game time in microseconds
+*/
+long long gameTime(GameStateType *game) {
+    if (!game) return 0; // Check for NULL pointer
+    if (game->virtualTime) return __atomic_load_n(&game->clockNow, __ATOMIC_RELAXED);
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000LL + now.tv_nsec / 1000 - game->startTime;
+}
+
+/*  Function: gameClockLeave()
+    Description: Called by a thread that will not sleep again so the others no longer wait for it
+
+    in/out: GameStateType *game - Pointer to the game the calling thread belongs to
+
+    Returns: None
+*/
+void gameClockLeave(GameStateType *game) {
+    if (!game || !game->virtualTime) return; // The clock is only used in virtual time
+    pthread_mutex_lock(&game->clockLock);
+    game->clockThreads--;
+    clockAdvance(game);
+    pthread_mutex_unlock(&game->clockLock);
+}
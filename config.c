@@ -0,0 +1,354 @@
+#include "defs.h"
+
+// Maps the name used on the command line or in a config file to a field of ConfigType
+typedef struct {
+    const char *key;
+    size_t offset;
+    int min;
+} ConfigKeyType;
+
+static const ConfigKeyType configKeys[] = {
+    { "boredom_max", offsetof(ConfigType, boredomMax), 1 },
+    { "fear_max",    offsetof(ConfigType, fearMax),    1 },
+    { "hunter_wait", offsetof(ConfigType, hunterWait), 0 },
+    { "ghost_wait",  offsetof(ConfigType, ghostWait),  0 },
+    { "num_hunters", offsetof(ConfigType, numHunters), 1 },
+    { "num_ghosts",  offsetof(ConfigType, numGhosts),  1 },
+    { "ev_per_ghost",offsetof(ConfigType, evPerGhost), 1 },
+    { "confidence",  offsetof(ConfigType, confidence), 1 },
+    { "drop_batch",  offsetof(ConfigType, dropBatch),  1 },
+    { "collect_all", offsetof(ConfigType, collectAll), 0 },
+    { "virtual_time",offsetof(ConfigType, virtualTime),0 },
+    { "workers",     offsetof(ConfigType, workers),    0 },
+    { "ev_lifetime", offsetof(ConfigType, evLifetime), 0 },
+    { "room_capacity", offsetof(ConfigType, roomCapacity), 0 },
+    { "bonus",       offsetof(ConfigType, bonus),      0 },
+    { "prompt",      offsetof(ConfigType, prompt),     0 },
+    { "logging",     offsetof(ConfigType, logging),    0 },
+    { "echo_queue",  offsetof(ConfigType, echoQueue),  0 },
+    { "games",       offsetof(ConfigType, games),      1 },
+    { "stats",       offsetof(ConfigType, stats),      0 },
+    { "snapshot_at", offsetof(ConfigType, snapshotAt), 0 },
+    { "snapshot_every", offsetof(ConfigType, snapshotEvery), 0 },
+    { "reseed",      offsetof(ConfigType, reseed),     0 },
+    { "jobs",        offsetof(ConfigType, jobs),       1 },
+    { "metrics_every", offsetof(ConfigType, metricsEvery), 1 },
+    { "stress",      offsetof(ConfigType, stress),     0 },
+    { "fuzz",        offsetof(ConfigType, fuzz),       0 },
+    { "fuzz_threads", offsetof(ConfigType, fuzzThreads), 1 },
+    { "fuzz_seed",   offsetof(ConfigType, fuzzSeed),   0 },
+};
+
+#define CONFIG_KEY_COUNT (int) (sizeof(configKeys) / sizeof(configKeys[0]))
+
+/*  Function: findConfigKey()
+    Description: Finds the entry in the key table with the given name
+
+    in: const char *key - The name of the parameter
+
+    Returns: const ConfigKeyType* - Pointer to the entry, NULL if there is no such parameter
+*/
+static const ConfigKeyType* findConfigKey(const char *key) {
+    for(int i = 0; i < CONFIG_KEY_COUNT; i++) {
+        if(strcmp(configKeys[i].key, key) == 0) return &configKeys[i];
+    }
+    return NULL;
+}
+
+/*  Function: parseInt()
+    Description: Converts a whole string to an integer, used for the config and roster files
+
+    in: const char *str - The string to convert
+    out: int *value - The converted value
+
+    Returns: int - C_TRUE if the whole string was a number that fits in an int, C_FALSE otherwise
+*/
+int parseInt(const char *str, int *value) {
+    char *end;
+    long result = strtol(str, &end, 10);
+    if(end == str || *end != '\0' || result < INT_MIN || result > INT_MAX) return C_FALSE;
+    *value = (int) result;
+    return C_TRUE;
+}
+
+/*  Function: initConfig()
+    Description: Fills a ConfigType struct with the default simulation parameters
+
+    out: ConfigType *config - Pointer to the ConfigType struct to initialize
+
+    Returns: None
+*/
+void initConfig(ConfigType *config) {
+    config->boredomMax = BOREDOM_MAX;
+    config->fearMax = FEAR_MAX;
+    config->hunterWait = HUNTER_WAIT;
+    config->ghostWait = GHOST_WAIT;
+    config->numHunters = NUM_HUNTERS;
+    config->numGhosts = NUM_GHOSTS;
+    config->evPerGhost = EV_PER_GHOST;
+    config->confidence = 100;
+    config->dropBatch = 1;
+    config->collectAll = C_FALSE;
+    config->virtualTime = C_FALSE;
+    config->workers = 0;
+    config->evLifetime = 0;
+    config->roomCapacity = 0;
+    config->policy = MOVE_RANDOM;
+    config->bonus = C_FALSE;
+    config->prompt = C_TRUE;
+    config->logging = LOGGING;
+    config->echoQueue = ECHO_QUEUE;
+    config->games = 1;
+    config->stats = C_FALSE;
+    config->csvPath[0] = '\0';
+    config->snapshotPath[0] = '\0';
+    config->restorePath[0] = '\0';
+    config->rosterPath[0] = '\0';
+    config->cpuList[0] = '\0';
+    config->jobs = 1;
+    config->metricsPath[0] = '\0';
+    config->replayPath[0] = '\0';
+    config->metricsEvery = 1000;
+    config->roster = NULL;
+    config->snapshotAt = 0;
+    config->snapshotEvery = 0;
+    config->reseed = C_FALSE;
+    config->stress = 0;
+    config->fuzz = 0;
+    config->fuzzThreads = 4;
+    config->fuzzSeed = 0;
+    config->sweepCount = 0;
+}
+
+/*  Function: setConfigValue()
+    Description: Sets one parameter by name
+
+    in/out: ConfigType *config - Pointer to the ConfigType struct to change
+    in: const char *key - The name of the parameter, e.g. "boredom_max"
+    in: const char *value - The new value as a string
+
+    Returns: int - C_TRUE if the parameter was set, C_FALSE if the key or value is invalid
+*/
+int setConfigValue(ConfigType *config, const char *key, const char *value) {
+    if(strcmp(key, "policy") == 0) {
+        MovePolicyType policy = policyFromString(value);
+        if(policy == MOVE_POLICY_COUNT) return C_FALSE;
+        config->policy = policy;
+        return C_TRUE;
+    }
+
+    // Paths are the only parameters that are not numbers
+    char *path = NULL;
+    if(strcmp(key, "csv") == 0) path = config->csvPath;
+    if(strcmp(key, "snapshot") == 0) path = config->snapshotPath;
+    if(strcmp(key, "restore") == 0) path = config->restorePath;
+    if(strcmp(key, "roster") == 0) path = config->rosterPath;
+    if(strcmp(key, "metrics") == 0) path = config->metricsPath;
+    if(strcmp(key, "replay") == 0) path = config->replayPath;
+    if(strcmp(key, "cpus") == 0) {
+        cpu_set_t cpus;
+        if(!parseCpuList(value, &cpus)) return C_FALSE;
+        path = config->cpuList;
+    }
+    if(path) {
+        if(strlen(value) >= MAX_PATH) return C_FALSE;
+        strcpy(path, value);
+        return C_TRUE;
+    }
+
+    const ConfigKeyType *entry = findConfigKey(key);
+    int number;
+    if(!entry || !parseInt(value, &number) || number < entry->min) return C_FALSE;
+
+    *(int*) ((char*) config + entry->offset) = number;
+    return C_TRUE;
+}
+
+/*  Function: getConfigValue()
+    Description: Reads one integer parameter by name
+
+    in: const ConfigType *config - Pointer to the ConfigType struct to read
+    in: const char *key - The name of the parameter, e.g. "boredom_max"
+    out: int *value - The current value of the parameter
+
+    Returns: int - C_TRUE if the parameter exists, C_FALSE otherwise
+*/
+int getConfigValue(const ConfigType *config, const char *key, int *value) {
+    const ConfigKeyType *entry = findConfigKey(key);
+    if(!entry) return C_FALSE;
+
+    *value = *(const int*) ((const char*) config + entry->offset);
+    return C_TRUE;
+}
+
+/*  Function: addSweep()
+    Description: Adds a parameter range to the sweep grid
+
+    in/out: ConfigType *config - Pointer to the ConfigType struct to add the sweep to
+    in: const char *spec - The range in the form key:from:to[:step]
+
+    Returns: int - C_TRUE if the range was added, C_FALSE if it is invalid
+*/
+int addSweep(ConfigType *config, const char *spec) {
+    if(config->sweepCount >= MAX_SWEEPS) return C_FALSE;
+    SweepType *sweep = &config->sweeps[config->sweepCount];
+    char key[MAX_STR];
+    int step = 1;
+
+    int read = sscanf(spec, "%63[^:]:%d:%d:%d", key, &sweep->from, &sweep->to, &step);
+    if(read < 3 || step <= 0 || sweep->to < sweep->from) return C_FALSE;
+    // Every point of the range has to be a value the key accepts
+    const ConfigKeyType *entry = findConfigKey(key);
+    if(!entry || sweep->from < entry->min) return C_FALSE;
+
+    strcpy(sweep->key, key);
+    sweep->step = step;
+    config->sweepCount++;
+    return C_TRUE;
+}
+
+/*  Function: loadConfigFile()
+    Description: Reads "key = value" lines from a file, blank lines and lines starting with # are skipped.
+                 A "sweep = key:from:to:step" line adds a range to the sweep grid.
+
+    in/out: ConfigType *config - Pointer to the ConfigType struct to fill
+    in: const char *path - Path of the config file
+
+    Returns: int - C_TRUE if the whole file was valid, C_FALSE otherwise
+*/
+int loadConfigFile(ConfigType *config, const char *path) {
+    FILE *file = fopen(path, "r");
+    if(!file) {
+        printf("Could not open config file %s\n", path);
+        return C_FALSE;
+    }
+
+    char line[MAX_STR + MAX_PATH * 2];
+    int lineNum = 0;
+    int valid = C_TRUE;
+
+    while(fgets(line, sizeof(line), file)) {
+        char key[MAX_STR];
+        char value[MAX_PATH];
+        lineNum++;
+
+        // Skip comments and blank lines
+        char first;
+        if(sscanf(line, " %c", &first) != 1 || first == '#') continue;
+
+        int ok = sscanf(line, " %63[^= \t] = %255s", key, value) == 2;
+        if(ok && strcmp(key, "sweep") == 0) {
+            ok = addSweep(config, value);
+        } else if(ok) {
+            ok = setConfigValue(config, key, value);
+        }
+
+        if(!ok) {
+            printf("%s:%d: invalid setting: %s", path, lineNum, line);
+            valid = C_FALSE;
+        }
+    }
+
+    fclose(file);
+    return valid;
+}
+
+/*  Function: parseArgs()
+    Description: Fills the config from the command line. Accepts --config=FILE, --sweep=key:from:to[:step],
+                 --key=value for any parameter, and the older "bonus" and policy name arguments.
+
+    in/out: ConfigType *config - Pointer to the ConfigType struct to fill
+    in: int argc - Number of arguments
+    in: char *argv[] - The arguments
+
+    Returns: int - C_TRUE if every argument was valid, C_FALSE otherwise
+*/
+int parseArgs(ConfigType *config, int argc, char *argv[]) {
+    for(int i = 1; i < argc; i++) {
+        char *arg = argv[i];
+        int ok;
+
+        if(strcmp(arg, "bonus") == 0) {
+            config->bonus = C_TRUE;
+            ok = C_TRUE;
+        } else if(policyFromString(arg) != MOVE_POLICY_COUNT) {
+            config->policy = policyFromString(arg);
+            ok = C_TRUE;
+        } else if(strncmp(arg, "--config=", 9) == 0) {
+            ok = loadConfigFile(config, arg + 9);
+        } else if(strncmp(arg, "--sweep=", 8) == 0) {
+            ok = addSweep(config, arg + 8);
+        } else if(strncmp(arg, "--", 2) == 0 && strchr(arg, '=')) {
+            // Split --key=value, dashes in the key are accepted in place of underscores
+            char key[MAX_STR];
+            int len = strchr(arg, '=') - (arg + 2);
+            if(len >= MAX_STR) len = MAX_STR - 1;
+            for(int j = 0; j < len; j++) key[j] = arg[2 + j] == '-' ? '_' : arg[2 + j];
+            key[len] = '\0';
+            ok = setConfigValue(config, key, strchr(arg, '=') + 1);
+        } else {
+            ok = C_FALSE;
+        }
+
+        if(!ok) {
+            printf("Invalid argument: %s\n", arg);
+            return C_FALSE;
+        }
+    }
+
+    return C_TRUE;
+}
+
+/*  Function: runSweep()
+    Description: Runs config->games games at every point of the sweep grid and prints how often the hunters won,
+                 the full summary tables are printed per point when config->stats is set
+
+    in: const ConfigType *base - The config that the swept parameters are applied on top of
+    in: FILE *csv - File to stream one row per game to, NULL to skip the CSV output
+
+    Returns: int - C_TRUE if every grid point was run, C_FALSE if one could not be applied
+*/
+int runSweep(const ConfigType *base, FILE *csv) {
+    ConfigType config = *base;
+    int values[MAX_SWEEPS];
+    // CSV rows carry on numbering from the previous grid point so every game of the sweep has its own
+    long played = 0;
+
+    for(int i = 0; i < config.sweepCount; i++) values[i] = config.sweeps[i].from;
+
+    while(1) {
+        // Apply the current grid point
+        char point[MAX_STR * MAX_SWEEPS] = "";
+        for(int i = 0; i < config.sweepCount; i++) {
+            char value[MAX_STR];
+            sprintf(value, "%d", values[i]);
+            if(!setConfigValue(&config, config.sweeps[i].key, value)) {
+                printf("Could not set %s=%s for the sweep\n", config.sweeps[i].key, value);
+                return C_FALSE;
+            }
+            sprintf(point + strlen(point), "%s%s=%d", i > 0 ? " " : "", config.sweeps[i].key, values[i]);
+        }
+
+        StatsType stats;
+        initStats(&stats, csv);
+        stats.csvFirst = played;
+        for(int game = 0; game < config.games; game++) {
+            runGame(&config, &stats);
+        }
+        played += stats.games;
+        printf("[SWEEP] %s hunters won %ld/%ld, mean ticks %.1f\n", point, stats.hunterWins, stats.games, stats.ticks.mean);
+        if(config.stats) printStats(stdout, &stats);
+        cleanupStats(&stats);
+
+        // Advance the grid like an odometer, the last parameter changes fastest
+        int i = config.sweepCount - 1;
+        while(i >= 0) {
+            values[i] += config.sweeps[i].step;
+            if(values[i] <= config.sweeps[i].to) break;
+            values[i] = config.sweeps[i].from;
+            i--;
+        }
+        if(i < 0) break;
+    }
+    return C_TRUE;
+}
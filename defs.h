@@ -1,27 +1,45 @@
+// Needed for the CPU affinity calls
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <unistd.h>
 #include <pthread.h>
 #include <semaphore.h>
 #include <time.h>
+#include <limits.h>
+#include <sched.h>
 
 #define MAX_STR         64
 #define MAX_RUNS        50
-#define BOREDOM_MAX     100
+#define MAX_SWEEPS      4
+#define MAX_PATH        256
+#define STAT_BINS       20
+#define STAT_BIN_WIDTH  25
 #define C_TRUE          1
 #define C_FALSE         0
+#define LOGGING         C_TRUE
+#define ECHO_QUEUE      1024
+#define FUZZ_MAX        256
+#define FUZZ_LISTS      4
+#define FUZZ_ROOMS      16
+
+// Defaults for ConfigType, every one of these can be changed at runtime
+#define BOREDOM_MAX     100
 #define HUNTER_WAIT     5000
 #define GHOST_WAIT      600
 #define NUM_HUNTERS     4
+#define NUM_GHOSTS      1
 #define EV_PER_GHOST    3
 #define FEAR_MAX        10
-#define LOGGING         C_TRUE
 
 typedef enum EvidenceType EvidenceType;
 typedef enum GhostClass GhostClass;
 typedef enum GhostAction GhostActionType;
 typedef enum HunterAction HunterActionType;
+typedef enum MovePolicy MovePolicyType;
+typedef enum ProfileSection ProfileSection;
 
 typedef struct Room RoomType;
 typedef struct RoomNode RoomNodeType;
@@ -29,43 +47,99 @@ typedef struct RoomList RoomListType;
 typedef struct EvidenceNode EvidenceNodeType;
 typedef struct EvidenceList EvidenceListType;
 typedef struct HunterList HunterListType;
+typedef struct GhostList GhostListType;
 
 typedef struct House HouseType;
+typedef struct PathTable PathTableType;
+typedef struct GameState GameStateType;
+typedef struct Config ConfigType;
+typedef struct Sweep SweepType;
+typedef struct RosterEntry RosterEntryType;
+typedef struct Roster RosterType;
+typedef struct RunningStat RunningStatType;
+typedef struct Histogram HistogramType;
+typedef struct Stats StatsType;
+typedef struct WorkItem WorkItemType;
+typedef struct Worker WorkerType;
+typedef struct Partition PartitionType;
+typedef struct Replay ReplayType;
+typedef struct FuzzList FuzzListType;
+typedef struct FuzzWorker FuzzWorkerType;
 
 typedef struct Hunter HunterType;
 typedef struct Ghost GhostType;
 
 enum EvidenceType { EMF, TEMPERATURE, FINGERPRINTS, SOUND, EV_COUNT, EV_UNKNOWN };
-enum GhostClass { POLTERGEIST, BANSHEE, BULLIES, PHANTOM, GHOST_COUNT, GH_UNKNOWN };
-enum LoggerDetails { LOG_FEAR, LOG_BORED, LOG_EVIDENCE, LOG_SUFFICIENT, LOG_INSUFFICIENT, LOG_UNKNOWN };
+
+// Every ghost class with its name and the evidence it leaves, X(class, name, evidence mask).
+// The enum, names and evidence lookups are all generated from this list, a new class only needs a line here.
+#define EV_BIT(ev) (1 << (ev))
+#define GHOST_CLASSES(X) \
+    X(POLTERGEIST, "Poltergeist", EV_BIT(EMF) | EV_BIT(TEMPERATURE) | EV_BIT(FINGERPRINTS)) \
+    X(BANSHEE,     "Banshee",     EV_BIT(EMF) | EV_BIT(TEMPERATURE) | EV_BIT(SOUND)) \
+    X(BULLIES,     "Bullies",     EV_BIT(EMF) | EV_BIT(FINGERPRINTS) | EV_BIT(SOUND)) \
+    X(PHANTOM,     "Phantom",     EV_BIT(TEMPERATURE) | EV_BIT(FINGERPRINTS) | EV_BIT(SOUND))
+
+#define GHOST_CLASS_ENUM(cls, name, evidence) cls,
+enum GhostClass { GHOST_CLASSES(GHOST_CLASS_ENUM) GHOST_COUNT, GH_UNKNOWN };
+enum LoggerDetails { LOG_FEAR, LOG_BORED, LOG_EVIDENCE, LOG_SUFFICIENT, LOG_INSUFFICIENT, LOG_ALONE, LOG_UNKNOWN };
 enum GhostAction { DROP_EVIDENCE, NOTHING, GHOST_MOVE_ROOM, GHOST_ACTION_COUNT };
 enum HunterAction { HUNTER_MOVE_ROOM, COLLECT_EV, REVIEW, HUNTER_ACTION_COUNT };
+enum MovePolicy { MOVE_RANDOM, MOVE_EXPLORE, MOVE_EVIDENCE, MOVE_POLICY_COUNT };
+// Operations fuzz mode runs on the evidence and room lists, see fuzz.c
+enum FuzzOp { FUZZ_ADD, FUZZ_TAKE, FUZZ_RANDOM, FUZZ_MOVE_ALL, FUZZ_EXPIRE, FUZZ_CLEAR, FUZZ_ROOM_ADD, FUZZ_ROOM_RANDOM,
+    FUZZ_ROOM_CLEAR, FUZZ_OP_COUNT };
+// Sections the profiler charges time to, every section from PROF_OVERHEAD on counts as work
+enum ProfileSection { PROF_SLEEP, PROF_LOCK, PROF_LOG, PROF_OVERHEAD, PROF_HUNTER_MOVE, PROF_HUNTER_COLLECT,
+    PROF_HUNTER_REVIEW, PROF_GHOST_MOVE, PROF_GHOST_DROP, PROF_SECTION_COUNT };
 
 struct Hunter {
     int id;
     char name[MAX_STR];
     RoomType *room;
+    int roomSlot;
+    // Set while the hunter has left its room and not yet entered the next, changed under the room semaphores
+    int moving;
     EvidenceType evidence;
     int fear;
     int boredom;
+    int fearMax;
+    int boredomMax;
     EvidenceListType *sharedEv;
-    EvidenceListType *ghostEv;
+    GhostListType *ghosts;
+    int reviewedGen;
+    EvidenceNodeType *reviewedTail;
+    int *foundEv;
     HunterListType *allHunters;
     int sufficientEv;
+    HouseType *house;
+    MovePolicyType policy;
+    int moves;
+    int *visitedAt;
+    int *seenDrops;
+    GameStateType *game;
+    const ConfigType *config;
+    int ticks;
+    enum LoggerDetails exitReason;
+    unsigned int seed;
 };
 
 struct HunterList {
-    HunterType *hunters[NUM_HUNTERS];
+    HunterType **hunters;
     int size;
+    int capacity;
 };
 
 struct EvidenceNode {
     struct EvidenceNode *next;
     EvidenceType data;
+    int source;
+    long long dropTime;
 };
 
 struct EvidenceList {
     int size;
+    int generation; // Bumped whenever evidence is appended, read atomically without the semaphore
     EvidenceNodeType *head;
     EvidenceNodeType *tail;
     sem_t evSem;
@@ -83,11 +157,15 @@ struct RoomList {
 };
 
 struct Room {
+    int id;
     char name[MAX_STR];
     EvidenceListType *evidenceList;
     RoomListType *connectedRooms;
     HunterListType *hunterList;
-    GhostType *ghost;
+    int hunterCount;
+    int ghostCount;
+    int evDrops[EV_COUNT];
+    int visits;
     sem_t roomSem;
 };
 
@@ -95,38 +173,284 @@ struct House {
     RoomListType *rooms;
     EvidenceListType *evidence;
     HunterListType *hunterList;
+    GhostListType *ghostList;
+    int roomCount;
+    RoomType **roomIndex;
+    PathTableType *paths;
+    GameStateType *game;
+};
+
+struct PathTable {
+    int size;
+    unsigned short *dist;
+    unsigned short *nextHop;
 };
 
 struct Ghost {
+    int id;
     GhostClass class;
     int boredomTimer;
     RoomType *currentRoom;
     EvidenceListType *evList;
     HunterListType *allHunters;
+    GameStateType *game;
+    const ConfigType *config;
+    int ticks;
+    int exited;
+    int identified;
+    GhostClass deduced;
+    int confidence;
+    unsigned int seed;
+    HouseType *house;
+};
+
+struct GhostList {
+    GhostType **ghosts;
+    int size;
+    int capacity;
+};
+
+// A hunter or ghost owned by a worker, exactly one of the two pointers is set
+struct WorkItem {
+    HunterType *hunter;
+    GhostType *ghost;
+    long long due;
+};
+
+// Steps the entities in one region of the house, entities that leave the region are sent to the
+// owner of the room they moved into through its inbox
+struct Worker {
+    int id;
+    PartitionType *partition;
+    WorkItemType *items;
+    int size;
+    int capacity;
+    WorkItemType *inbox;
+    int inboxSize;
+    int inboxCapacity;
+    pthread_mutex_t inboxLock;
+    long long nextDue;
+};
+
+// The rooms of a house split into connected regions, one per worker. Workers run in rounds that
+// end at a barrier, game time jumps to the earliest due entity between rounds.
+struct Partition {
+    HouseType *house;
+    int workerCount;
+    int *roomRegion;
+    WorkerType *workers;
+    pthread_barrier_t roundEnd;
+    pthread_barrier_t roundStart;
+    long long now;
+    int done;
+};
+
+// Shared between every thread of a game, the counters are only accessed atomically.
+// When the game can be paused, threads hold pauseLock for reading while they act so a snapshot can stop the world.
+struct GameState {
+    int huntersActive;
+    int ghostsActive;
+    int solved;
+    int evDropped[EV_COUNT];
+    int evCollected[EV_COUNT];
+    int evExpired;
+    pthread_rwlock_t pauseLock;
+    // Only snapshots and the stress checker pause a game, without them pauseLock is never taken
+    int pausable;
+    // Set for a game rebuilt by replay mode, which must not draw from the RNG
+    int replaying;
+    // Virtual clock, only used when the game runs in virtual time
+    int virtualTime;
+    long long startTime;
+    long long clockNow;
+    int clockThreads;
+    int clockSleeping;
+    long long *clockWake;
+    pthread_mutex_t clockLock;
+    pthread_cond_t clockCond;
+};
+
+// One parameter of the grid walked by sweep mode
+struct Sweep {
+    char key[MAX_STR];
+    int from;
+    int to;
+    int step;
+};
+
+// One hunter read from a roster file, limits of 0 and MOVE_POLICY_COUNT mean the config value is used
+struct RosterEntry {
+    char name[MAX_STR];
+    EvidenceType evidence;
+    int fearMax;
+    int boredomMax;
+    MovePolicyType policy;
+};
+
+struct Roster {
+    RosterEntryType *entries;
+    int size;
+    int capacity;
+};
+
+// A game being rebuilt from its log, see replay.c
+struct Replay {
+    HouseType *house;
+    const ConfigType *config;
+    int line;
+    long events;
+    long errors;
+    long mismatches;
+    int *owed;      // Evidence collected before its drop was logged, EV_COUNT per room
+    unsigned char *ghostRooms; // Rooms each ghost could be in, house->roomCount flags per ghost
+    int ghostExits;
+    int summary;    // C_TRUE while reading the evidence list at the end of the log
+    int summaryEv[EV_COUNT];
+};
+
+// An evidence list with the plain array it is checked against, only used while holding the list's evSem
+struct FuzzList {
+    EvidenceListType *list;
+    long long now;
+    int size;
+    EvidenceType data[FUZZ_MAX];
+    int source[FUZZ_MAX];
+    long long dropTime[FUZZ_MAX];
+};
+
+// One fuzz thread, the evidence lists are shared and the room with its connections is its own
+struct FuzzWorker {
+    int id;
+    unsigned int seed;
+    long ops;
+    FuzzListType *lists;
+    RoomType *room;
+    RoomType *targets[FUZZ_ROOMS];
+    RoomType *connected[FUZZ_ROOMS];
+    int connectedCount;
+    long counts[FUZZ_OP_COUNT];
+    pthread_t thread;
+};
+
+struct Config {
+    int boredomMax;
+    int fearMax;
+    int hunterWait;
+    int ghostWait;
+    int numHunters;
+    int numGhosts;
+    int evPerGhost;
+    int confidence;
+    int dropBatch;
+    int collectAll;
+    int virtualTime;
+    int workers;
+    int evLifetime;
+    int roomCapacity;
+    MovePolicyType policy;
+    int bonus;
+    int prompt;
+    int logging;
+    int echoQueue;
+    int games;
+    int stats;
+    char csvPath[MAX_PATH];
+    char snapshotPath[MAX_PATH];
+    char restorePath[MAX_PATH];
+    char rosterPath[MAX_PATH];
+    char cpuList[MAX_PATH];
+    int jobs;
+    char metricsPath[MAX_PATH];
+    char replayPath[MAX_PATH];
+    int metricsEvery;
+    const RosterType *roster;
+    int snapshotAt;
+    int snapshotEvery;
+    int reseed;
+    int stress;
+    int fuzz;
+    int fuzzThreads;
+    int fuzzSeed;
+    int sweepCount;
+    SweepType sweeps[MAX_SWEEPS];
+};
+
+// Count, mean and variance of a stream of values using Welford's method
+struct RunningStat {
+    long count;
+    double mean;
+    double m2;
+    double min;
+    double max;
+};
+
+// Fixed width bins starting at 0, values past the last bin are counted as overflow
+struct Histogram {
+    long bins[STAT_BINS];
+    long overflow;
+};
+
+// Aggregates any number of games in constant memory
+struct Stats {
+    long games;
+    long hunterWins;
+    long gamesByClass[GHOST_COUNT];
+    long winsByClass[GHOST_COUNT];
+    long hunterExits[LOG_UNKNOWN + 1];
+    RunningStatType ticks;
+    HistogramType tickHist;
+    RunningStatType evDropped[EV_COUNT];
+    RunningStatType evCollected[EV_COUNT];
+    RunningStatType evExpired;
+    RunningStatType confidence;
+    long misidentified;
+    int roomCount;
+    long *roomVisits;
+    char (*roomNames)[MAX_STR];
+    FILE *csv;
+    // CSV rows are numbered first + 1, first + 1 + stride, ... so parallel jobs never share a number
+    long csvFirst;
+    long csvStride;
 };
 
 // Hunter Functions
 HunterListType* createHunterList();
-void initHunter(HunterType**, GhostType*, HouseType*, char[], int*, EvidenceType);
+void initHunter(HunterType**, GhostListType*, HouseType*, char[], int*, EvidenceType, const ConfigType*);
 pthread_t* startHunterThread(HunterType*);
 void *hunterLogic(void*);
+int hunterActive(HunterType*);
+int hunterStep(HunterType*);
+void hunterFinish(HunterType*);
 void moveRoomHunt(HunterType*);
+RoomType* chooseHunterRoom(HunterType*);
+void markVisited(HunterType*, RoomType*);
 void addHunter(HunterListType*, HunterType*);
 void collectEvidence(HunterType*);
+void collectAllEvidence(HunterType*);
 int delHunter(HunterListType*, int);
 void copyHunter(HunterType*, HunterType*);
 int review(HunterType*);
 void hunterExit(HunterType*);
+void cleanupHunter(HunterType*);
 void cleanupHunterList(HunterListType*);
 
 // Ghost Functions
-void initGhost(HouseType*, GhostType**);
+void initGhost(HouseType*, GhostType**, const ConfigType*);
+void createGhost(HouseType*, GhostType**, GhostClass, RoomType*, const ConfigType*);
 void ghostMoveRoom(GhostType*);
 void dropEvidence(GhostType*);
+void dropEvidenceBatch(GhostType*, int);
 int checkIfHunterInRoom(RoomType*);
 pthread_t* startGhostThread(GhostType*);
+void *ghostLogic(void*);
+int ghostActive(GhostType*);
+void ghostStep(GhostType*);
+void ghostFinish(GhostType*);
 void ghostExit(GhostType*);
 void cleanupGhost(GhostType*);
+GhostListType* createGhostList();
+void addGhost(GhostListType*, GhostType*);
+void cleanupGhostList(GhostListType*);
 
 // Room Functions
 struct Room* createRoom(char*);
@@ -134,6 +458,10 @@ void connectRooms(RoomType*, RoomType*);
 void createRoomNode(RoomType*, RoomNodeType**);
 RoomListType* createConnectedRoomList();
 RoomType* findRandomConnectedRoom(RoomType*);
+void roomAddHunter(RoomType*, HunterType*);
+void roomRemoveHunter(RoomType*, HunterType*);
+void expireRoomEvidence(RoomType*, GameStateType*, const ConfigType*);
+void resetRoom(RoomType*);
 void cleanupRoomListData(RoomListType*);
 void cleanupRoomList(RoomListType*);
 
@@ -141,9 +469,14 @@ void cleanupRoomList(RoomListType*);
 EvidenceListType* createEvidenceList();
 void createEvidenceNode (EvidenceType, EvidenceNodeType**);
 void addEvidence (EvidenceListType*, EvidenceType);
+void addSourcedEvidence(EvidenceListType*, EvidenceType, int, long long);
 void printEvidence(FILE*, EvidenceListType*);
 EvidenceType removeEvidence(EvidenceListType*, EvidenceType);
+EvidenceType takeEvidence(EvidenceListType*, EvidenceType, int*);
+int moveAllEvidence(EvidenceListType*, EvidenceListType*, EvidenceType);
+int expireEvidence(EvidenceListType*, long long, long long, int);
 EvidenceType randomEvidence(EvidenceListType*);
+void clearEvidenceList(EvidenceListType*);
 void cleanupEvidenceList(EvidenceListType*);
 
 // House Functions 
@@ -151,26 +484,157 @@ void initHouse(HouseType**);
 void addRoom(RoomListType**, RoomType*);
 void populateRooms(HouseType*);
 RoomType* randomRoomInHouse(HouseType*);
+void indexHouse(HouseType*);
+void acquireHouse(HouseType**);
+void releaseHouse(HouseType*);
+void resetHouse(HouseType*);
+void cleanupHouseCache();
 void cleanupHouse(HouseType*);
 
+// Game Functions
+int runGame(const ConfigType*, StatsType*);
+GameStateType* createGameState();
+void resetGameState(GameStateType*);
+void gameHunterJoined(GameStateType*);
+void gameHunterLeft(GameStateType*);
+void gameGhostJoined(GameStateType*);
+void gameGhostLeft(GameStateType*);
+void gameSolved(GameStateType*);
+void gameEvidenceDropped(GameStateType*, EvidenceType, int);
+void gameEvidenceCollected(GameStateType*, EvidenceType, int);
+void gameEvidenceExpired(GameStateType*, int);
+int isGameSolved(GameStateType*);
+int isGameWon(HouseType*);
+int isHuntOver(GameStateType*);
+int isHauntOver(GameStateType*);
+void gameEnter(GameStateType*);
+void gameLeave(GameStateType*);
+void runGameThreads(HouseType*);
+void cleanupGameState(GameStateType*);
+
+// Worker Functions
+void partitionHouse(PartitionType*, HouseType*, int);
+void runPartitioned(HouseType*, int);
+void cleanupPartition(PartitionType*);
+
+// Stress Test Functions
+pthread_t* startOccupancyCheck(HouseType*);
+void stopOccupancyCheck(pthread_t*);
+void stressInTransit();
+int runStress(const ConfigType*);
+
+// Fuzz Functions
+int runFuzz(const ConfigType*);
+
+// Replay Functions
+int runReplay(const ConfigType*);
+
+// Virtual Clock Functions
+void gameClockStart(GameStateType*, int);
+void simSleep(GameStateType*, int);
+void gameClockLeave(GameStateType*);
+long long gameTime(GameStateType*);
+
+// Snapshot Functions
+int saveSnapshot(const char*, HouseType*);
+int loadSnapshot(const char*, const ConfigType*, HouseType**);
+
+// Roster Functions
+int loadRoster(const char*, RosterType**);
+void cleanupRoster(RosterType*);
+
+// Config Functions
+void initConfig(ConfigType*);
+int parseArgs(ConfigType*, int, char*[]);
+int loadConfigFile(ConfigType*, const char*);
+int setConfigValue(ConfigType*, const char*, const char*);
+int getConfigValue(const ConfigType*, const char*, int*);
+int addSweep(ConfigType*, const char*);
+int runSweep(const ConfigType*, FILE*);
+int parseInt(const char*, int*);
+
+// Statistics Functions
+void initStats(StatsType*, FILE*);
+void addRunningStat(RunningStatType*, double);
+double runningStatVariance(RunningStatType*);
+void addHistogram(HistogramType*, double);
+void mergeStats(StatsType*, const StatsType*);
+void recordGame(StatsType*, const ConfigType*, HouseType*);
+void writeCsvHeader(FILE*);
+void printStats(FILE*, StatsType*);
+void cleanupStats(StatsType*);
+
+// Metrics Functions
+void metricsGame(HouseType*, int, int);
+void metricsLockWait(long long);
+int metricsEnabled();
+void startMetrics(const ConfigType*);
+void stopMetrics();
+
+// Job Functions
+int parseCpuList(const char*, cpu_set_t*);
+void describeCpuSet(const cpu_set_t*, char*, size_t);
+void runJobs(const ConfigType*, StatsType*);
+
+// Path Functions
+PathTableType* buildPathTable(HouseType*);
+int pathDistance(PathTableType*, int, int);
+RoomType* pathNextRoom(HouseType*, RoomType*, RoomType*);
+void cleanupPathTable(PathTableType*);
+
 // Helper Utilies
 int randInt(int,int);        // Pseudo-random number generator function
 float randFloat(float, float);  // Pseudo-random float generator function
+void useRandomSeed(unsigned int*); // Make the calling thread draw from the given seed
+unsigned int newRandomSeed();   // A fresh non-zero seed for an entity
 enum GhostClass randomGhost();  // Return a randomly selected a ghost type
-void ghostToString(GhostClass, char*); // Convert a ghost type to a string, stored in output paremeter
-void evidenceToString(EvidenceType, char*); // Convert an evidence type to a string, stored in output parameter
+const char* ghostName(GhostClass); // The name of a ghost type
+int ghostEvidence(GhostClass);  // The evidence a ghost type leaves as a mask of EV_BIT()s
+GhostClass ghostFromEvidence(int); // The ghost type that leaves exactly the evidence in the mask
+GhostClass deduceGhost(int, int*, int); // The most likely ghost type given the evidence found, with its confidence
+const char* evidenceName(EvidenceType); // The name of an evidence type
+int countBits(int);             // The number of bits set in a mask
 void* safeMalloc(size_t);
+MovePolicyType policyFromString(const char*);
+void waitSemaphor(sem_t*);
 void lockSemaphors(sem_t*, sem_t*);
 void unlockSemaphors(sem_t*, sem_t*);
 
+// Profiler, only built with -DPROFILE so the macros cost nothing otherwise
+#ifdef PROFILE
+void profileThreadStart();
+void profileBegin(ProfileSection);
+void profileEnd();
+void profileThreadDone();
+void profileReport(FILE*);
+#define PROFILE_THREAD_START()      profileThreadStart()
+#define PROFILE_BEGIN(section)      profileBegin(section)
+#define PROFILE_END()               profileEnd()
+#define PROFILE_THREAD_DONE()       profileThreadDone()
+#define PROFILE_REPORT(out)         profileReport(out)
+#else
+#define PROFILE_THREAD_START()      ((void) 0)
+#define PROFILE_BEGIN(section)      ((void) 0)
+#define PROFILE_END()               ((void) 0)
+#define PROFILE_THREAD_DONE()       ((void) 0)
+#define PROFILE_REPORT(out)         ((void) 0)
+#endif
+
 // Logging Utilities
+void l_setLogging(int);
+void l_startEcho(int);
+void l_flushEcho();
+void l_stopEcho();
+void l_gameStart();
 void l_hunterInit(char*, enum EvidenceType);
 void l_hunterMove(char*, char*);
 void l_hunterReview(char*, enum LoggerDetails);
 void l_hunterCollect(char*, enum EvidenceType, char*);
+void l_hunterCollectBatch(char*, enum EvidenceType, int, char*);
 void l_hunterExit(char*, enum LoggerDetails);
 void l_ghostInit(enum GhostClass, char*);
 void l_ghostMove(char*);
 void l_ghostEvidence(enum EvidenceType, char*);
+void l_ghostEvidenceBatch(int[], char*);
 void l_ghostExit(enum LoggerDetails);
-void l_gameComplete(GhostType*, HunterListType*, EvidenceListType*);
+void l_gameComplete(GhostListType*, HunterListType*, EvidenceListType*, int);
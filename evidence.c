@@ -10,6 +10,7 @@
 EvidenceListType* createEvidenceList() {
     EvidenceListType *newEvidenceList = safeMalloc(sizeof(EvidenceListType));
     newEvidenceList->size = 0;
+    newEvidenceList->generation = 0;
     newEvidenceList->head = NULL;
     newEvidenceList->tail = NULL;
     sem_init(&newEvidenceList->evSem, 0, 1);
@@ -18,7 +19,7 @@ EvidenceListType* createEvidenceList() {
 }
 
 /*  Function: addEvidence()
-    Description: Adds a new EvidenceType to the end of the EvidenceListType
+    Description: Adds a new EvidenceType that did not come from a ghost to the end of the EvidenceListType
 
     in/out: EvidenceListType *evidenceList - Pointer to the EvidenceListType to add to
     in: EvidenceType evidenceType - The EvidenceType to add to the list
@@ -26,10 +27,26 @@ EvidenceListType* createEvidenceList() {
     Returns: None
 */
 void addEvidence(EvidenceListType *evidenceList, EvidenceType evidenceType) {
+    addSourcedEvidence(evidenceList, evidenceType, -1, 0);
+}
+
+/*  Function: addSourcedEvidence()
+    Description: Adds a new EvidenceType to the end of the EvidenceListType, remembering which ghost left it
+
+    in/out: EvidenceListType *evidenceList - Pointer to the EvidenceListType to add to
+    in: EvidenceType evidenceType - The EvidenceType to add to the list
+    in: int source - The id of the ghost that left the evidence, -1 if it did not come from a ghost
+    in: long long dropTime - The game time the evidence was left at, see gameTime()
+    
+    Returns: None
+*/
+void addSourcedEvidence(EvidenceListType *evidenceList, EvidenceType evidenceType, int source, long long dropTime) {
     if (!evidenceList) return; // Check for NULL pointer
 
     EvidenceNodeType *newNode;  
     createEvidenceNode(evidenceType, &newNode);
+    newNode->source = source;
+    newNode->dropTime = dropTime;
     
     // Add the node to the end of the list
     if(evidenceList->tail == NULL) {
@@ -42,6 +59,7 @@ void addEvidence(EvidenceListType *evidenceList, EvidenceType evidenceType) {
     
     // Increment the size of the list
     evidenceList->size++; 
+    __atomic_add_fetch(&evidenceList->generation, 1, __ATOMIC_RELEASE);
 }
 
 /*  Function: printEvidence()
@@ -57,10 +75,8 @@ void printEvidence(FILE* logFile, EvidenceListType *evList) {
 
     for(int i = 0; i < evList->size; i++) {
         // Print out all of the evidence nodes in the list
-        char evStr[MAX_STR];
-        evidenceToString(currNode->data, evStr);
-        printf(" - %s\n", evStr);
-        fprintf(logFile, " - %s\n", evStr);
+        printf(" - %s\n", evidenceName(currNode->data));
+        fprintf(logFile, " - %s\n", evidenceName(currNode->data));
         currNode = currNode->next;
     }
 }
@@ -77,6 +93,8 @@ void createEvidenceNode(EvidenceType evidenceType, EvidenceNodeType **node) {
     *node = safeMalloc(sizeof(EvidenceNodeType));
 
     (*node)->data = evidenceType;
+    (*node)->source = -1;
+    (*node)->dropTime = 0;
     (*node)->next = NULL; 
 }
 
@@ -85,9 +103,10 @@ void createEvidenceNode(EvidenceType evidenceType, EvidenceNodeType **node) {
 
     in: EvidenceListType *evidenceList - Pointer to the EvidenceListType to get the random EvidenceType from
     
-    Returns: EvidenceType - The random EvidenceType
+    Returns: EvidenceType - The random EvidenceType, EV_UNKNOWN if the list is empty
 */
 EvidenceType randomEvidence(EvidenceListType *evidenceList) {
+    if (!evidenceList || evidenceList->size == 0) return EV_UNKNOWN;
     EvidenceNodeType *currEv = evidenceList->head;
     int randIndex = randInt(0, evidenceList->size);
 
@@ -108,6 +127,19 @@ EvidenceType randomEvidence(EvidenceListType *evidenceList) {
     Returns: EvidenceType - The removed EvidenceType
 */
 EvidenceType removeEvidence(EvidenceListType *evidenceList, EvidenceType evidenceType) {
+    return takeEvidence(evidenceList, evidenceType, NULL);
+}
+
+/*  Function: takeEvidence()
+    Description: Removes the first node with the given EvidenceType and reports which ghost left it
+
+    in/out: EvidenceListType *evidenceList - Pointer to the EvidenceListType to remove from
+    in: EvidenceType evidenceType - The EvidenceType to remove from the list
+    out: int *source - The id of the ghost that left the evidence, may be NULL
+    
+    Returns: EvidenceType - The removed EvidenceType, EV_UNKNOWN if there was none
+*/
+EvidenceType takeEvidence(EvidenceListType *evidenceList, EvidenceType evidenceType, int *source) {
     if(evidenceList->size == 0) return EV_UNKNOWN;
     
     EvidenceNodeType *prevNode = NULL;
@@ -135,20 +167,104 @@ EvidenceType removeEvidence(EvidenceListType *evidenceList, EvidenceType evidenc
     evidenceList->size--;
 
     EvidenceType data = currEv->data;
+    if (source) *source = currEv->source;
 
     free(currEv);
     
     return data;
 }
 
-/*  Function: cleanupEvidenceList()
-    Description: Frees all the memory allocated to the EvidenceListType
+/*  Function: moveAllEvidence()
+    Description: Moves every node with the given EvidenceType to the end of another list in one pass.
+                 The nodes are relinked rather than copied so their sources are kept.
 
-    in/out: EvidenceListType *evidenceList - Pointer to the EvidenceListType to free
+    in/out: EvidenceListType *src - Pointer to the EvidenceListType to take the evidence from
+    in/out: EvidenceListType *dest - Pointer to the EvidenceListType to add the evidence to
+    in: EvidenceType evidenceType - The EvidenceType to move
+    
+    Returns: int - The number of pieces of evidence that were moved
+*/
+int moveAllEvidence(EvidenceListType *src, EvidenceListType *dest, EvidenceType evidenceType) {
+    if (!src || !dest) return 0; // Check for NULL pointers
+    EvidenceNodeType *prevNode = NULL;
+    EvidenceNodeType *currEv = src->head;
+    int moved = 0;
+
+    while (currEv) {
+        EvidenceNodeType *nextNode = currEv->next;
+        if (currEv->data != evidenceType) {
+            prevNode = currEv;
+            currEv = nextNode;
+            continue;
+        }
+
+        // Unlink the node from the source list
+        if (!prevNode) {
+            src->head = nextNode;
+        } else {
+            prevNode->next = nextNode;
+        }
+        if (currEv == src->tail) src->tail = prevNode;
+        src->size--;
+
+        // Link it onto the end of the destination list
+        currEv->next = NULL;
+        if (dest->tail) {
+            dest->tail->next = currEv;
+        } else {
+            dest->head = currEv;
+        }
+        dest->tail = currEv;
+        dest->size++;
+
+        moved++;
+        currEv = nextNode;
+    }
+
+    if(moved > 0) __atomic_add_fetch(&dest->generation, 1, __ATOMIC_RELEASE);
+    return moved;
+}
+
+/*  Function: expireEvidence()
+    Description: Removes evidence from the front of the list while it is older than its lifetime or the
+                 list holds more than its capacity. Evidence is only ever appended in the order it was
+                 dropped, so the oldest is always at the front and each piece is looked at once.
+
+    in/out: EvidenceListType *evidenceList - Pointer to the EvidenceListType to expire evidence from
+    in: long long now - The current game time, see gameTime()
+    in: long long lifetime - How long evidence lasts, 0 if it never expires
+    in: int capacity - How much evidence the list can hold, 0 if there is no limit
+    
+    Returns: int - The number of pieces of evidence that were removed
+*/
+int expireEvidence(EvidenceListType *evidenceList, long long now, long long lifetime, int capacity) {
+    if (!evidenceList) return 0; // Check for NULL pointer
+    int expired = 0;
+
+    while (evidenceList->head) {
+        EvidenceNodeType *oldest = evidenceList->head;
+        int tooOld = lifetime > 0 && oldest->dropTime + lifetime <= now;
+        int tooMany = capacity > 0 && evidenceList->size > capacity;
+        if (!tooOld && !tooMany) break;
+
+        evidenceList->head = oldest->next;
+        if (!evidenceList->head) evidenceList->tail = NULL;
+        evidenceList->size--;
+        free(oldest);
+        expired++;
+    }
+
+    return expired;
+}
+
+/*  Function: clearEvidenceList()
+    Description: Frees every node of the EvidenceListType and leaves it empty so it can be used again
+
+    in/out: EvidenceListType *evidenceList - Pointer to the EvidenceListType to empty
     
     Returns: None
 */
-void cleanupEvidenceList(EvidenceListType *evidenceList) {
+void clearEvidenceList(EvidenceListType *evidenceList) {
     if (!evidenceList) return; // Check for NULL pointer
 
     EvidenceNodeType *currentNode = evidenceList->head;
@@ -162,5 +278,21 @@ void cleanupEvidenceList(EvidenceListType *evidenceList) {
         currentNode = nextNode;
     }  
 
+    evidenceList->head = NULL;
+    evidenceList->tail = NULL;
+    evidenceList->size = 0;
+    evidenceList->generation = 0;
+}
+
+/*  Function: cleanupEvidenceList()
+    Description: Frees all the memory allocated to the EvidenceListType
+
+    in/out: EvidenceListType *evidenceList - Pointer to the EvidenceListType to free
+    
+    Returns: None
+*/
+void cleanupEvidenceList(EvidenceListType *evidenceList) {
+    if (!evidenceList) return; // Check for NULL pointer
+    clearEvidenceList(evidenceList);
     free(evidenceList);
 }
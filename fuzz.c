@@ -0,0 +1,400 @@
+#include "defs.h"
+
+/*
+    Fuzz mode runs random sequences of operations on the evidence and room lists and checks every
+    result and the whole list after every operation against a plain array holding what the list
+    should contain. The evidence lists are shared by all of the threads and locked with their evSem
+    the same way the game locks them, each thread has its own room whose connections it grows and
+    empties, as the rooms are only read by the game once the house is built.
+
+    --fuzz=N runs N operations on each of --fuzz-threads threads and prints the throughput, so a
+    replacement list can be checked and timed with the same driver. --fuzz-seed picks the seeds,
+    0 picks one from the clock. Built with -DFUZZ the same operations are driven by libFuzzer
+    through LLVMFuzzerTestOneInput(), three bytes per operation.
+*/
+
+// Only the first few errors are printed, the rest are counted
+#define FUZZ_SHOWN      10
+
+static const char *fuzzOpNames[FUZZ_OP_COUNT] = {
+    "add", "take", "random", "move_all", "expire", "clear", "room_add", "room_random", "room_clear"
+};
+
+// Total over every thread, only accessed atomically
+static long fuzzErrors = 0;
+
+/*  Function: fuzzError()
+    Description: Counts a result that did not match the model and prints the first few
+
+    in: int op - The operation that went wrong
+    in: const char *message - What was wrong
+
+    Returns: None
+*/
+static void fuzzError(int op, const char *message) {
+    long errors = __atomic_add_fetch(&fuzzErrors, 1, __ATOMIC_RELAXED);
+    if(errors > FUZZ_SHOWN) return;
+    // A broken list usually crashes soon after, so the report can not wait in the buffer
+    printf("[FUZZ] %s: %s\n", fuzzOpNames[op], message);
+    fflush(stdout);
+}
+
+/*  Function: checkList()
+    Description: Walks an evidence list and compares every node, its size and its tail with the model,
+                 the caller must hold the list's evSem
+
+    in: FuzzListType *fuzzList - The list and its model
+    in: int op - The operation that was just run
+
+    Returns: None
+*/
+static void checkList(FuzzListType *fuzzList, int op) {
+    EvidenceListType *list = fuzzList->list;
+    EvidenceNodeType *node = list->head, *last = NULL;
+    int count = 0;
+
+    while(node && count < fuzzList->size) {
+        if(node->data != fuzzList->data[count] || node->source != fuzzList->source[count] || node->dropTime != fuzzList->dropTime[count]) {
+            fuzzError(op, "evidence list does not match the model");
+            return;
+        }
+        last = node;
+        node = node->next;
+        count++;
+    }
+    if(node || count != fuzzList->size || list->size != fuzzList->size) fuzzError(op, "evidence list has the wrong size");
+    if(list->tail != last || (last && last->next)) fuzzError(op, "evidence list tail is not its last node");
+}
+
+/*  Function: modelRemove()
+    Description: Removes one entry from a list's model
+
+    in/out: FuzzListType *fuzzList - The list whose model to change
+    in: int index - The entry to remove
+
+    Returns: None
+*/
+static void modelRemove(FuzzListType *fuzzList, int index) {
+    for(int i = index; i < fuzzList->size - 1; i++) {
+        fuzzList->data[i] = fuzzList->data[i + 1];
+        fuzzList->source[i] = fuzzList->source[i + 1];
+        fuzzList->dropTime[i] = fuzzList->dropTime[i + 1];
+    }
+    fuzzList->size--;
+}
+
+/*  Function: fuzzEvidence()
+    Description: Runs one operation on an evidence list and checks it, the caller must hold the list's evSem
+
+    in/out: FuzzListType *fuzzList - The list and its model
+    in: int op - The operation to run
+    in: unsigned int a - Chooses the list, also the lifetime for FUZZ_EXPIRE
+    in: unsigned int b - The operation's argument
+
+    Returns: None
+*/
+static void fuzzEvidence(FuzzListType *fuzzList, int op, unsigned int a, unsigned int b) {
+    EvidenceListType *list = fuzzList->list;
+    EvidenceType ev = (EvidenceType) (b % EV_COUNT);
+
+    if(op == FUZZ_ADD && fuzzList->size < FUZZ_MAX) {
+        int source = (int) (b / EV_COUNT % 8) - 1;
+        addSourcedEvidence(list, ev, source, fuzzList->now);
+        fuzzList->data[fuzzList->size] = ev;
+        fuzzList->source[fuzzList->size] = source;
+        fuzzList->dropTime[fuzzList->size] = fuzzList->now++;
+        fuzzList->size++;
+    } else if(op == FUZZ_TAKE) {
+        int index = 0;
+        while(index < fuzzList->size && fuzzList->data[index] != ev) index++;
+        int source = -2;
+        EvidenceType taken = takeEvidence(list, ev, &source);
+        if(index == fuzzList->size) {
+            if(taken != EV_UNKNOWN) fuzzError(op, "took evidence that was not in the list");
+        } else {
+            if(taken != ev || source != fuzzList->source[index]) fuzzError(op, "took the wrong evidence");
+            modelRemove(fuzzList, index);
+        }
+    } else if(op == FUZZ_RANDOM) {
+        EvidenceType picked = randomEvidence(list);
+        int found = C_FALSE;
+        for(int i = 0; i < fuzzList->size && !found; i++) found = fuzzList->data[i] == picked;
+        if(fuzzList->size == 0 ? picked != EV_UNKNOWN : !found) fuzzError(op, "picked evidence that is not in the list");
+    } else if(op == FUZZ_EXPIRE) {
+        int capacity = b % (FUZZ_MAX / 4);
+        long long lifetime = a / FUZZ_LISTS % 32;
+        int expected = 0;
+        while(fuzzList->size > 0 && ((lifetime > 0 && fuzzList->dropTime[0] + lifetime <= fuzzList->now) || (capacity > 0 && fuzzList->size > capacity))) {
+            modelRemove(fuzzList, 0);
+            expected++;
+        }
+        if(expireEvidence(list, fuzzList->now, lifetime, capacity) != expected) fuzzError(op, "expired the wrong amount of evidence");
+    } else if(op == FUZZ_CLEAR && b % 16 == 0) {
+        // Rare so the lists get long enough to matter
+        clearEvidenceList(list);
+        fuzzList->size = 0;
+    }
+    checkList(fuzzList, op);
+}
+
+/*  Function: fuzzMoveAll()
+    Description: Moves every piece of one evidence type between two lists and checks both,
+                 the caller must hold both lists' evSems
+
+    in/out: FuzzListType *src - The list the evidence is taken from
+    in/out: FuzzListType *dest - The list the evidence is added to
+    in: EvidenceType ev - The evidence type to move
+
+    Returns: None
+*/
+static void fuzzMoveAll(FuzzListType *src, FuzzListType *dest, EvidenceType ev) {
+    int expected = 0;
+    for(int i = 0; i < src->size; i++) expected += src->data[i] == ev;
+    // The model can not grow past FUZZ_MAX
+    if(dest->size + expected > FUZZ_MAX) return;
+
+    for(int i = 0; i < src->size; ) {
+        if(src->data[i] != ev) {
+            i++;
+            continue;
+        }
+        dest->data[dest->size] = ev;
+        dest->source[dest->size] = src->source[i];
+        dest->dropTime[dest->size] = src->dropTime[i];
+        dest->size++;
+        modelRemove(src, i);
+    }
+
+    if(moveAllEvidence(src->list, dest->list, ev) != expected) fuzzError(FUZZ_MOVE_ALL, "moved the wrong amount of evidence");
+    checkList(src, FUZZ_MOVE_ALL);
+    checkList(dest, FUZZ_MOVE_ALL);
+}
+
+/*  Function: fuzzRooms()
+    Description: Runs one operation on the worker's room connections and checks them
+
+    in/out: FuzzWorkerType *worker - The worker whose room to use
+    in: int op - The operation to run
+    in: unsigned int b - The operation's argument
+
+    Returns: None
+*/
+static void fuzzRooms(FuzzWorkerType *worker, int op, unsigned int b) {
+    RoomType *room = worker->room;
+
+    if(op == FUZZ_ROOM_ADD && worker->connectedCount < FUZZ_ROOMS) {
+        RoomType *target = worker->targets[b % FUZZ_ROOMS];
+        addRoom(&room->connectedRooms, target);
+        worker->connected[worker->connectedCount++] = target;
+    } else if(op == FUZZ_ROOM_RANDOM) {
+        RoomType *picked = findRandomConnectedRoom(room);
+        int found = C_FALSE;
+        for(int i = 0; i < worker->connectedCount && !found; i++) found = worker->connected[i] == picked;
+        if(worker->connectedCount == 0 ? picked != NULL : !found) fuzzError(op, "picked a room that is not connected");
+    } else if(op == FUZZ_ROOM_CLEAR && (b % 16 == 0 || worker->connectedCount == FUZZ_ROOMS)) {
+        cleanupRoomList(room->connectedRooms);
+        room->connectedRooms = createConnectedRoomList();
+        worker->connectedCount = 0;
+    }
+
+    RoomNodeType *node = room->connectedRooms->head, *last = NULL;
+    int count = 0;
+    while(node && count < worker->connectedCount) {
+        if(node->data != worker->connected[count]) {
+            fuzzError(op, "room list does not match the model");
+            return;
+        }
+        last = node;
+        node = node->next;
+        count++;
+    }
+    if(node || count != worker->connectedCount || room->connectedRooms->size != count) fuzzError(op, "room list has the wrong size");
+    if(room->connectedRooms->tail != last) fuzzError(op, "room list tail is not its last node");
+}
+
+/*  Function: fuzzStep()
+    Description: Runs one operation, locking the evidence lists it touches
+
+    in/out: FuzzWorkerType *worker - The worker running the operation
+    in: int op - The operation to run
+    in: unsigned int a - Chooses the evidence list
+    in: unsigned int b - The operation's argument
+
+    Returns: None
+*/
+static void fuzzStep(FuzzWorkerType *worker, int op, unsigned int a, unsigned int b) {
+    worker->counts[op]++;
+    if(op >= FUZZ_ROOM_ADD) {
+        fuzzRooms(worker, op, b);
+        return;
+    }
+
+    FuzzListType *fuzzList = &worker->lists[a % FUZZ_LISTS];
+    if(op == FUZZ_MOVE_ALL) {
+        FuzzListType *dest = &worker->lists[b / EV_COUNT % FUZZ_LISTS];
+        if(dest == fuzzList) return;
+        lockSemaphors(&fuzzList->list->evSem, &dest->list->evSem);
+        fuzzMoveAll(fuzzList, dest, (EvidenceType) (b % EV_COUNT));
+        sem_post(&fuzzList->list->evSem);
+        sem_post(&dest->list->evSem);
+        return;
+    }
+
+    waitSemaphor(&fuzzList->list->evSem);
+    fuzzEvidence(fuzzList, op, a, b);
+    sem_post(&fuzzList->list->evSem);
+}
+
+/*  Function: createFuzzLists()
+    Description: Creates the evidence lists every worker shares, all empty
+
+    in: None
+
+    Returns: FuzzListType* - The FUZZ_LISTS lists
+*/
+static FuzzListType* createFuzzLists() {
+    FuzzListType *lists = safeMalloc(sizeof(FuzzListType) * FUZZ_LISTS);
+    for(int i = 0; i < FUZZ_LISTS; i++) {
+        lists[i].list = createEvidenceList();
+        lists[i].now = 0;
+        lists[i].size = 0;
+    }
+    return lists;
+}
+
+/*  Function: initFuzzWorker()
+    Description: Sets up a worker with its own room and the rooms it can connect to
+
+    out: FuzzWorkerType *worker - The worker to set up
+    in: int id - The worker's number
+    in: unsigned int seed - The worker's random seed
+    in: long ops - How many operations it runs
+    in: FuzzListType *lists - The shared evidence lists
+
+    Returns: None
+*/
+static void initFuzzWorker(FuzzWorkerType *worker, int id, unsigned int seed, long ops, FuzzListType *lists) {
+    worker->id = id;
+    worker->seed = seed;
+    worker->ops = ops;
+    worker->lists = lists;
+    worker->room = createRoom("Fuzz Room");
+    for(int i = 0; i < FUZZ_ROOMS; i++) worker->targets[i] = createRoom("Fuzz Target");
+    worker->connectedCount = 0;
+    memset(worker->counts, 0, sizeof(worker->counts));
+}
+
+/*  Function: cleanupFuzzWorker()
+    Description: Frees the worker's rooms
+
+    in/out: FuzzWorkerType *worker - The worker to clean up
+
+    Returns: None
+*/
+static void cleanupFuzzWorker(FuzzWorkerType *worker) {
+    RoomListType *rooms = createConnectedRoomList();
+    addRoom(&rooms, worker->room);
+    for(int i = 0; i < FUZZ_ROOMS; i++) addRoom(&rooms, worker->targets[i]);
+    cleanupRoomListData(rooms);
+    cleanupRoomList(rooms);
+}
+
+/*  Function: cleanupFuzzLists()
+    Description: Frees the shared evidence lists
+
+    in/out: FuzzListType *lists - The lists to free
+
+    Returns: None
+*/
+static void cleanupFuzzLists(FuzzListType *lists) {
+    for(int i = 0; i < FUZZ_LISTS; i++) cleanupEvidenceList(lists[i].list);
+    free(lists);
+}
+
+/*  Function: fuzzLogic()
+    Description: Runs a worker's random operations
+
+    in/out: void *arg - The FuzzWorkerType to run
+
+    Returns: void* - NULL
+*/
+static void* fuzzLogic(void *arg) {
+    FuzzWorkerType *worker = (FuzzWorkerType*) arg;
+    // The lists draw from the same seed, so a run only depends on its seeds and the thread timing
+    useRandomSeed(&worker->seed);
+    for(long i = 0; i < worker->ops; i++) {
+        int op = rand_r(&worker->seed) % FUZZ_OP_COUNT;
+        unsigned int a = rand_r(&worker->seed);
+        unsigned int b = rand_r(&worker->seed);
+        fuzzStep(worker, op, a, b);
+    }
+    return NULL;
+}
+
+/*  Function: runFuzz()
+    Description: Runs config->fuzz operations on each of config->fuzzThreads threads, then prints
+                 the errors found and the throughput
+
+    in: const ConfigType *config - The parameters to fuzz with
+
+    Returns: int - C_TRUE if every operation matched the model, C_FALSE otherwise
+*/
+int runFuzz(const ConfigType *config) {
+    unsigned int seed = config->fuzzSeed > 0 ? (unsigned int) config->fuzzSeed : (unsigned int) time(NULL);
+    int threads = config->fuzzThreads;
+    FuzzListType *lists = createFuzzLists();
+    FuzzWorkerType *workers = safeMalloc(sizeof(FuzzWorkerType) * threads);
+    for(int i = 0; i < threads; i++) initFuzzWorker(&workers[i], i, seed + i, config->fuzz, lists);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(int i = 0; i < threads; i++) pthread_create(&workers[i].thread, NULL, fuzzLogic, &workers[i]);
+    for(int i = 0; i < threads; i++) pthread_join(workers[i].thread, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    // Every list has to match its model once the threads are done as well
+    for(int i = 0; i < FUZZ_LISTS; i++) checkList(&lists[i], FUZZ_ADD);
+
+    long counts[FUZZ_OP_COUNT] = {0};
+    long total = 0;
+    for(int i = 0; i < threads; i++) {
+        for(int op = 0; op < FUZZ_OP_COUNT; op++) counts[op] += workers[i].counts[op];
+        cleanupFuzzWorker(&workers[i]);
+    }
+    for(int op = 0; op < FUZZ_OP_COUNT; op++) total += counts[op];
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("[FUZZ] seed %u, %d threads, %ld ops, %ld errors in %.3fs (%.0f ops/s)\n", seed, threads, total,
+        fuzzErrors, seconds, seconds > 0 ? total / seconds : 0.0);
+    for(int op = 0; op < FUZZ_OP_COUNT; op++) printf("[FUZZ]   %-12s %ld\n", fuzzOpNames[op], counts[op]);
+
+    free(workers);
+    cleanupFuzzLists(lists);
+    return fuzzErrors == 0;
+}
+
+#ifdef FUZZ
+/*  Function: LLVMFuzzerTestOneInput()
+    Description: libFuzzer entry point, runs one operation for every three bytes of the input on
+                 fresh lists in a single thread and aborts on the first mismatch
+
+    in: const unsigned char *data - The input
+    in: size_t size - The input's length
+
+    Returns: int - Always 0
+*/
+int LLVMFuzzerTestOneInput(const unsigned char *data, size_t size) {
+    FuzzListType *lists = createFuzzLists();
+    FuzzWorkerType worker;
+    initFuzzWorker(&worker, 0, 1, 0, lists);
+    useRandomSeed(&worker.seed);
+
+    for(size_t i = 0; i + 2 < size; i += 3) fuzzStep(&worker, data[i] % FUZZ_OP_COUNT, data[i + 1], data[i + 2]);
+    for(int i = 0; i < FUZZ_LISTS; i++) checkList(&lists[i], FUZZ_ADD);
+
+    cleanupFuzzWorker(&worker);
+    cleanupFuzzLists(lists);
+    if(fuzzErrors > 0) abort();
+    return 0;
+}
+#endif
@@ -0,0 +1,452 @@
+#include "defs.h"
+
+/*  Function: setupGame()
+    Description: Builds the house, ghosts and hunters for a new game. The hunters come from config->roster
+                 when one was loaded, from stdin when config->prompt is set, otherwise they are named Hunter1, Hunter2, ...
+                 With config->bonus their evidence is asked for too, as long as config->prompt is set.
+
+    in: const ConfigType *config - The parameters to run the game with
+    out: HouseType **house - Pointer to the newly created house
+    
+    Returns: None
+*/
+static void setupGame(const ConfigType *config, HouseType **house) {
+    // The rooms are only built for the first game on a thread, later games reuse them
+    acquireHouse(house);
+    l_gameStart();
+
+    // Initialize the ghosts and add them to the house 
+    for(int i = 0; i < config->numGhosts; i++) {
+        GhostType *ghost;
+        initGhost(*house, &ghost, config);
+    }
+
+    HunterListType *hunterList = createHunterList();
+
+    // Initialize the hunters
+    const RosterType *roster = config->roster;
+    int hunterCount = roster ? roster->size : config->numHunters;
+    char hunterName[MAX_STR];
+    int ev;
+    // Used to give each hunter a unique id
+    int id = hunterCount;
+    // Used as an array to hold the current taken enum values for evidence
+    unsigned char takenEvidence = 0;
+    EvidenceListType *evList = NULL;
+    
+    // Asking for a user specified evidence changes the program so it is bonus only, batches never ask
+    int askEvidence = config->bonus && config->prompt;
+    if(!askEvidence && !roster) {
+        evList = createEvidenceList();
+    }
+    
+    // Loop to get information about the hunters 
+    while(id > 0) {
+        HunterType *currentHunter;
+        // The roster was validated when it was loaded so its hunters skip the prompts
+        const RosterEntryType *entry = roster ? &roster->entries[hunterCount - id] : NULL;
+        // The prompts go straight to the console so the lines logged before them have to be out first
+        if(!entry && config->prompt) l_flushEcho();
+
+        // Collect their name
+        if(entry) {
+            strcpy(hunterName, entry->name);
+        } else if(config->prompt) {
+            printf("Please enter the hunters name: ");
+            scanf("%s", hunterName);
+        } else {
+            sprintf(hunterName, "Hunter%d", hunterCount - id + 1);
+        }
+
+        // With more hunters than evidence types every type is handed out once before any repeats
+        if(takenEvidence == (1 << EV_COUNT) - 1) takenEvidence = 0;
+        
+        if(entry) {
+            ev = entry->evidence;
+        } else if(askEvidence) {
+            // Evidence has strict restrictions so loop until they are met 
+            while(1) {
+                printf("Please enter their evidence type (0 - EMF, 1 - TEMPERATURE, 2 - FINGERPRINTS, 3 - SOUND): ");
+                if(scanf("%d", &ev) != 1) {
+                    printf("Ran out of input while reading the hunters!\n");
+                    exit(EXIT_FAILURE);
+                }
+                // Check if it is a valid choice 
+                if(!(ev >= 0) || !(ev <= 3)) {
+                    printf("That is not a valid evidence type!\n");
+                    continue;
+                }
+
+                // Check if the bit at the enum int value is set 
+                if((takenEvidence >> ev) & 1) {
+                    printf("Please enter an evidence type that has not been taken!\n");
+                } else { 
+                    // Set the bit at the given enum value
+                    takenEvidence = takenEvidence | (1 << ev);
+                    break;
+                }
+            }
+        } else {
+            // Refill the choices once every type has been handed out
+            if(evList->size == 0) {
+                addEvidence(evList, FINGERPRINTS);
+                addEvidence(evList, EMF);
+                addEvidence(evList, SOUND);
+                addEvidence(evList, TEMPERATURE);
+            }
+            // Pick a random evidence from the remaining choices
+            ev = randomEvidence(evList);
+            // Remove it after since we can't have the same type twice 
+            removeEvidence(evList, ev);
+        }
+    
+        // Init the hunter and add it to our list
+        initHunter(&currentHunter, (*house)->ghostList, *house, hunterName, &id, (EvidenceType) ev, config);
+        if(entry && entry->fearMax > 0) currentHunter->fearMax = entry->fearMax;
+        if(entry && entry->boredomMax > 0) currentHunter->boredomMax = entry->boredomMax;
+        if(entry && entry->policy != MOVE_POLICY_COUNT) currentHunter->policy = entry->policy;
+        addHunter(hunterList, currentHunter);
+    }
+    
+    // If we create an evidence list then free it
+    cleanupEvidenceList(evList);
+    
+    // Reuse the hunter list for house
+    (*house)->hunterList = hunterList;
+}
+
+/*  Function: runGame()
+    Description: Sets up a new game, or restores one from config->restorePath, runs the threads
+                 until they all exit and logs the results.
+
+    in: const ConfigType *config - The parameters to run the game with
+    in/out: StatsType *stats - Aggregate the game's metrics are added to, NULL to skip
+
+    Returns: int - C_TRUE if the hunters won, C_FALSE if the ghosts won
+*/
+int runGame(const ConfigType *config, StatsType *stats) {
+    HouseType *house;
+
+    if(config->restorePath[0] != '\0') {
+        if(!loadSnapshot(config->restorePath, config, &house)) {
+            printf("Could not restore the game from %s\n", config->restorePath);
+            exit(EXIT_FAILURE);
+        }
+    } else {
+        setupGame(config, &house);
+    }
+
+    // Set before any thread starts, it decides whether gameEnter() takes the pause lock
+    house->game->pausable = config->snapshotPath[0] != '\0' || config->stress > 0;
+
+    // Stress runs check the house from another thread while the game is played
+    pthread_t *checker = config->stress > 0 ? startOccupancyCheck(house) : NULL;
+
+    // Workers keep their own game time between rounds instead of sleeping
+    house->game->virtualTime = config->virtualTime || config->workers > 0;
+    if(config->workers > 0) {
+        runPartitioned(house, config->workers);
+    } else {
+        runGameThreads(house);
+    }
+    stopOccupancyCheck(checker);
+
+    int huntersWon = isGameWon(house);
+    l_gameComplete(house->ghostList, house->hunterList, house->evidence, huntersWon);
+    recordGame(stats, config, house);
+
+    // Free the ghosts and hunters, a restored house is freed as well since its rooms came from the snapshot
+    if(config->restorePath[0] != '\0') {
+        cleanupHouse(house);
+    } else {
+        releaseHouse(house);
+    }
+
+    return huntersWon;
+}
+
+/*  Function: runGameThreads()
+    Description: Starts a thread for every ghost and hunter that is still in the house
+                 and waits for all of them to exit
+
+    in/out: HouseType *house - The house the game is played in
+    
+    Returns: None
+*/
+void runGameThreads(HouseType *house) {
+    HunterListType *hunterList = house->hunterList;
+    GhostListType *ghostList = house->ghostList;
+    pthread_t** ghostThreads = safeMalloc(sizeof(pthread_t*) * ghostList->size);
+    pthread_t** hunterThreads = safeMalloc(sizeof(pthread_t*) * hunterList->size);
+
+    // Restored games can contain entities that already left, every thread joins the clock before any of them starts
+    int threads = 0;
+    for(int i = 0; i < ghostList->size; i++) threads += !ghostList->ghosts[i]->exited;
+    for(int i = 0; i < hunterList->size; i++) threads += hunterList->hunters[i]->exitReason == LOG_UNKNOWN;
+    gameClockStart(house->game, threads);
+
+    for(int i = 0; i < ghostList->size; i++) {
+        GhostType *ghost = ghostList->ghosts[i];
+        ghostThreads[i] = !ghost->exited ? startGhostThread(ghost) : NULL;
+    }
+    for(int i = 0; i < hunterList->size; i++) {
+        HunterType *hunter = hunterList->hunters[i];
+        hunterThreads[i] = hunter->exitReason == LOG_UNKNOWN ? startHunterThread(hunter) : NULL;
+    }
+
+    // Wait for the threads to finish
+    for(int i = 0; i < ghostList->size; i++) {
+        if(ghostThreads[i]) pthread_join(*ghostThreads[i], NULL);
+    }
+    for(int i = 0; i < hunterList->size; i++) {
+        if(hunterThreads[i]) pthread_join(*hunterThreads[i], NULL);
+    }
+
+    // Cleanup the threads
+    for(int i = 0; i < ghostList->size; i++) {
+        free(ghostThreads[i]);
+    }
+    free(ghostThreads);
+    for(int i = 0; i < hunterList->size; i++) {
+        free(hunterThreads[i]);
+    }
+    free(hunterThreads);
+}
+
+/*  Function: createGameState()
+    Description: Creates a new GameStateType struct shared by every thread of one game
+
+    in: None
+
+    Returns: GameStateType* - Pointer to the newly created GameStateType struct
+*/
+GameStateType* createGameState() {
+    GameStateType *game = safeMalloc(sizeof(GameStateType));
+    game->clockWake = NULL;
+    resetGameState(game);
+    pthread_rwlock_init(&game->pauseLock, NULL);
+    pthread_mutex_init(&game->clockLock, NULL);
+    pthread_cond_init(&game->clockCond, NULL);
+    return game;
+}
+
+/*  Function: resetGameState()
+    Description: Clears the counters and clock of a game that has ended so it can be played again,
+                 the locks are kept
+
+    in/out: GameStateType *game - Pointer to the game to reset
+
+    Returns: None
+*/
+void resetGameState(GameStateType *game) {
+    if (!game) return; // Check for NULL pointer
+    game->huntersActive = 0;
+    game->ghostsActive = 0;
+    game->solved = C_FALSE;
+    memset(game->evDropped, 0, sizeof(game->evDropped));
+    memset(game->evCollected, 0, sizeof(game->evCollected));
+    game->evExpired = 0;
+    game->pausable = C_FALSE;
+    game->replaying = C_FALSE;
+    game->virtualTime = C_FALSE;
+    game->startTime = 0;
+    game->clockNow = 0;
+    game->clockThreads = 0;
+    game->clockSleeping = 0;
+}
+
+/*  Function: gameHunterJoined()
+    Description: Counts a hunter that is taking part in the hunt
+
+    in/out: GameStateType *game - Pointer to the game the hunter joined
+
+    Returns: None
+*/
+void gameHunterJoined(GameStateType *game) {
+    if (!game) return; // Check for NULL pointer
+    __atomic_add_fetch(&game->huntersActive, 1, __ATOMIC_SEQ_CST);
+}
+
+/*  Function: gameHunterLeft()
+    Description: Counts a hunter leaving the house, once none are left the ghost can stop
+
+    in/out: GameStateType *game - Pointer to the game the hunter left
+
+    Returns: None
+*/
+void gameHunterLeft(GameStateType *game) {
+    if (!game) return; // Check for NULL pointer
+    __atomic_sub_fetch(&game->huntersActive, 1, __ATOMIC_SEQ_CST);
+}
+
+/*  Function: gameGhostJoined()
+    Description: Counts a ghost that is haunting the house
+
+    in/out: GameStateType *game - Pointer to the game the ghost joined
+
+    Returns: None
+*/
+void gameGhostJoined(GameStateType *game) {
+    if (!game) return; // Check for NULL pointer
+    __atomic_add_fetch(&game->ghostsActive, 1, __ATOMIC_SEQ_CST);
+}
+
+/*  Function: gameGhostLeft()
+    Description: Counts a ghost leaving the house
+
+    in/out: GameStateType *game - Pointer to the game the ghost left
+
+    Returns: None
+*/
+void gameGhostLeft(GameStateType *game) {
+    if (!game) return; // Check for NULL pointer
+    __atomic_sub_fetch(&game->ghostsActive, 1, __ATOMIC_SEQ_CST);
+}
+
+/*  Function: gameSolved()
+    Description: Marks that a hunter reviewed sufficient evidence so the hunters have won
+
+    in/out: GameStateType *game - Pointer to the game that was solved
+
+    Returns: None
+*/
+void gameSolved(GameStateType *game) {
+    if (!game) return; // Check for NULL pointer
+    __atomic_store_n(&game->solved, C_TRUE, __ATOMIC_SEQ_CST);
+}
+
+/*  Function: gameEvidenceDropped()
+    Description: Counts pieces of evidence the ghost left behind
+
+    in/out: GameStateType *game - Pointer to the game the evidence was dropped in
+    in: EvidenceType ev - The type of evidence
+    in: int count - How many pieces of that type were dropped
+
+    Returns: None
+*/
+void gameEvidenceDropped(GameStateType *game, EvidenceType ev, int count) {
+    if (!game) return; // Check for NULL pointer
+    __atomic_add_fetch(&game->evDropped[ev], count, __ATOMIC_RELAXED);
+}
+
+/*  Function: gameEvidenceCollected()
+    Description: Counts pieces of evidence a hunter picked up
+
+    in/out: GameStateType *game - Pointer to the game the evidence was collected in
+    in: EvidenceType ev - The type of evidence
+    in: int count - How many pieces of that type were collected
+
+    Returns: None
+*/
+void gameEvidenceCollected(GameStateType *game, EvidenceType ev, int count) {
+    if (!game) return; // Check for NULL pointer
+    __atomic_add_fetch(&game->evCollected[ev], count, __ATOMIC_RELAXED);
+}
+
+/*  Function: gameEvidenceExpired()
+    Description: Counts pieces of evidence that decayed or were pushed out of a full room
+
+    in/out: GameStateType *game - Pointer to the game the evidence expired in
+    in: int count - How many pieces expired
+
+    Returns: None
+*/
+void gameEvidenceExpired(GameStateType *game, int count) {
+    if (!game) return; // Check for NULL pointer
+    __atomic_add_fetch(&game->evExpired, count, __ATOMIC_RELAXED);
+}
+
+/*  Function: isGameSolved()
+    Description: Checks if a hunter has already found sufficient evidence
+
+    in: GameStateType *game - Pointer to the game to check
+
+    Returns: int - C_TRUE if the game is solved, C_FALSE otherwise
+*/
+int isGameSolved(GameStateType *game) {
+    if (!game) return C_FALSE; // Check for NULL pointer
+    return __atomic_load_n(&game->solved, __ATOMIC_SEQ_CST);
+}
+
+/*  Function: isGameWon()
+    Description: Checks if the hunters finished the case and deduced the class of every ghost correctly
+
+    in: HouseType *house - Pointer to the house the game was played in
+
+    Returns: int - C_TRUE if the hunters won, C_FALSE otherwise
+*/
+int isGameWon(HouseType *house) {
+    if (!house || !isGameSolved(house->game)) return C_FALSE;
+    for(int i = 0; i < house->ghostList->size; i++) {
+        GhostType *ghost = house->ghostList->ghosts[i];
+        if(__atomic_load_n(&ghost->deduced, __ATOMIC_RELAXED) != ghost->class) return C_FALSE;
+    }
+    return C_TRUE;
+}
+
+/*  Function: isHuntOver()
+    Description: Checks if the hunters can stop because the outcome is decided
+
+    in: GameStateType *game - Pointer to the game to check
+
+    Returns: int - C_TRUE if the hunters should stop, C_FALSE otherwise
+*/
+int isHuntOver(GameStateType *game) {
+    return isGameSolved(game);
+}
+
+/*  Function: isHauntOver()
+    Description: Checks if the ghosts can stop because the outcome is decided,
+                 either the hunters have won or there are no hunters left to haunt
+
+    in: GameStateType *game - Pointer to the game to check
+
+    Returns: int - C_TRUE if the ghosts should stop, C_FALSE otherwise
+*/
+int isHauntOver(GameStateType *game) {
+    if (!game) return C_FALSE; // Check for NULL pointer
+    return isGameSolved(game) || __atomic_load_n(&game->huntersActive, __ATOMIC_SEQ_CST) == 0;
+}
+
+/*  Function: gameEnter()
+    Description: Called by a thread before it acts on the house, blocks while a snapshot is being taken.
+                 Does nothing unless the game can be paused.
+
+    in/out: GameStateType *game - Pointer to the game the thread belongs to
+
+    Returns: None
+*/
+void gameEnter(GameStateType *game) {
+    if (!game || !game->pausable) return; // Nothing can pause the game
+    PROFILE_BEGIN(PROF_LOCK);
+    pthread_rwlock_rdlock(&game->pauseLock);
+    PROFILE_END();
+}
+
+/*  Function: gameLeave()
+    Description: Called by a thread once it has finished acting on the house
+
+    in/out: GameStateType *game - Pointer to the game the thread belongs to
+
+    Returns: None
+*/
+void gameLeave(GameStateType *game) {
+    if (!game || !game->pausable) return; // gameEnter() did not take the lock
+    pthread_rwlock_unlock(&game->pauseLock);
+}
+
+/*  Function: cleanupGameState()
+    Description: Frees the memory allocated for the GameStateType struct
+
+    in/out: GameStateType *game - Pointer to the GameStateType struct to free
+
+    Returns: None
+*/
+void cleanupGameState(GameStateType *game) {
+    if (!game) return; // Check for NULL pointer
+    pthread_rwlock_destroy(&game->pauseLock);
+    pthread_mutex_destroy(&game->clockLock);
+    pthread_cond_destroy(&game->clockCond);
+    free(game->clockWake);
+    free(game);
+}
@@ -3,58 +3,69 @@
 void *ghostLogic(void*);
 
 /*  Function: initGhost()
-    Description: Creates a new GhostType struct and initializes its fields
+    Description: Creates a ghost of a random class in a random room and logs it
 
     in: HouseType *house - Pointer to the HouseType struct to add the ghost to
     in/out: GhostType **ghost - Pointer to the newly created GhostType struct
+    in: const ConfigType *config - The simulation parameters
     
     Returns: None
 */
-void initGhost(HouseType *house, GhostType **ghost) {
+void initGhost(HouseType *house, GhostType **ghost, const ConfigType *config) {
+    GhostClass ghostClass = randomGhost();
+    createGhost(house, ghost, ghostClass, randomRoomInHouse(house), config);
+    if (!(*ghost)) return; // Check if the ghost was created
+
+    l_ghostInit(ghostClass, (*ghost)->currentRoom->name);
+}
+
+/*  Function: createGhost()
+    Description: Creates a new GhostType struct, initializes its fields and adds it to the house's ghost list
+
+    in/out: HouseType *house - Pointer to the HouseType struct to add the ghost to
+    in/out: GhostType **ghost - Pointer to the newly created GhostType struct
+    in: GhostClass ghostClass - The class of the ghost
+    in: RoomType *spawnRoom - The room the ghost starts in
+    in: const ConfigType *config - The simulation parameters
+    
+    Returns: None
+*/
+void createGhost(HouseType *house, GhostType **ghost, GhostClass ghostClass, RoomType *spawnRoom, const ConfigType *config) {
     // Allocate memory for the new ghost
     (*ghost) = safeMalloc(sizeof(GhostType));
-    GhostClass ghostClass = randomGhost();
     (*ghost)->evList = createEvidenceList();
     if (!(*ghost)->evList) { // Check if evidence list creation was successful
         free(*ghost);
+        (*ghost) = NULL;
         return;
     }
     (*ghost)->class = ghostClass;
     
-    // Add the appropriate evidence to the ghost's evidence list
-    switch (ghostClass) {
-        case POLTERGEIST:
-            addEvidence((*ghost)->evList, EMF);
-            addEvidence((*ghost)->evList, TEMPERATURE);
-            addEvidence((*ghost)->evList, FINGERPRINTS);
-            break;
-        case BANSHEE:
-            addEvidence((*ghost)->evList, EMF);
-            addEvidence((*ghost)->evList, TEMPERATURE);
-            addEvidence((*ghost)->evList, SOUND);
-            break;
-        case BULLIES:
-            addEvidence((*ghost)->evList, EMF);
-            addEvidence((*ghost)->evList, FINGERPRINTS);
-            addEvidence((*ghost)->evList, SOUND);
-            break;
-        case PHANTOM:
-            addEvidence((*ghost)->evList, TEMPERATURE);
-            addEvidence((*ghost)->evList, FINGERPRINTS);
-            addEvidence((*ghost)->evList, SOUND);
-            break;
-        default:
-            break;
+    // Add the evidence the class leaves to the ghost's evidence list
+    for(int ev = 0; ev < EV_COUNT; ev++) {
+        if(ghostEvidence(ghostClass) & EV_BIT(ev)) addEvidence((*ghost)->evList, (EvidenceType) ev);
     }
 
     // Initialize the rest of the ghost's fields
-    RoomType *spawnRoom = randomRoomInHouse(house);
     (*ghost)->currentRoom = spawnRoom;
-    spawnRoom->ghost = (*ghost);
+    __atomic_add_fetch(&spawnRoom->ghostCount, 1, __ATOMIC_SEQ_CST);
     (*ghost)->allHunters = house->hunterList;
+    (*ghost)->config = config;
+    (*ghost)->ticks = 0;
+    (*ghost)->exited = C_FALSE;
+    (*ghost)->identified = C_FALSE;
+    (*ghost)->deduced = GH_UNKNOWN;
+    (*ghost)->confidence = 0;
+    (*ghost)->seed = newRandomSeed();
+    (*ghost)->house = house;
+    (*ghost)->game = house->game;
+    gameGhostJoined((*ghost)->game);
 
     (*ghost)->boredomTimer = 0;
-    l_ghostInit(ghostClass, (*ghost)->currentRoom->name);
+
+    // The position in the house's list doubles as the id evidence is tagged with
+    (*ghost)->id = house->ghostList->size;
+    addGhost(house->ghostList, *ghost);
 }
 
 /*  Function: startGhostThread()
@@ -82,64 +93,127 @@ void *ghostLogic(void *ghostPtr) {
     GhostType *ghost = (GhostType*) ghostPtr;
     if (!ghost) return NULL; // Check for NULL pointer
 
-    // Run the ghost logic until the ghost is bored
-    while(ghost->boredomTimer < BOREDOM_MAX) {
-        usleep(GHOST_WAIT);
-        
-        // Check if there is a hunter in the room
-        GhostActionType ghostAction;
-        struct Room *currRoom = ghost->currentRoom;
-        sem_wait(&currRoom->roomSem);
-        int hunterInRoom = checkIfHunterInRoom(currRoom);
-        sem_post(&currRoom->roomSem);
-        
-        // If there is a hunter in the room, reset the boredom timer and do not allow moving from a room
-        if (hunterInRoom) {
-            ghost->boredomTimer = 0;
-            ghostAction = randInt(0, GHOST_ACTION_COUNT - 1);
-        } else {
-            ghostAction = randInt(0, GHOST_ACTION_COUNT);
-            ghost->boredomTimer++;
-        }
+    const ConfigType *config = ghost->config;
+    useRandomSeed(&ghost->seed);
+    PROFILE_THREAD_START();
+
+    while(ghostActive(ghost)) {
+        PROFILE_BEGIN(PROF_SLEEP);
+        simSleep(ghost->game, config->ghostWait);
+        PROFILE_END();
+        ghostStep(ghost);
+    }
+    
+    ghostFinish(ghost);
+    gameClockLeave(ghost->game);
+    PROFILE_THREAD_DONE();
 
-        // Perform the action
-        switch(ghostAction) {
-            case GHOST_MOVE_ROOM: 
-                ghostMoveRoom(ghost);
-                break;
-            case DROP_EVIDENCE:
+    return NULL;
+}
+
+/*  Function: ghostActive()
+    Description: Checks if the ghost should keep haunting
+
+    in: GhostType *ghost - Pointer to the GhostType struct to check
+    
+    Returns: int - C_TRUE until the ghost is bored or the outcome of the game is decided
+*/
+int ghostActive(GhostType *ghost) {
+    return ghost->boredomTimer < ghost->config->boredomMax && !isHauntOver(ghost->game);
+}
+
+/*  Function: ghostStep()
+    Description: Performs one turn of the ghost, the caller is responsible for waiting between turns
+                 and for making the ghost's seed the calling thread's random state
+
+    in/out: GhostType *ghost - Pointer to the GhostType struct to act
+    
+    Returns: None
+*/
+void ghostStep(GhostType *ghost) {
+    const ConfigType *config = ghost->config;
+
+    // Snapshots are taken between actions while no thread is acting on the house, the first ghost keeps time
+    if(config->snapshotPath[0] != '\0' && ghost->id == 0 && ghost->ticks > 0 && (ghost->ticks == config->snapshotAt || 
+        (config->snapshotEvery > 0 && ghost->ticks % config->snapshotEvery == 0))) {
+        saveSnapshot(config->snapshotPath, ghost->house);
+    }
+
+    gameEnter(ghost->game);
+    ghost->ticks++;
+    
+    // Check if there is a hunter in the room
+    GhostActionType ghostAction;
+    int hunterInRoom = checkIfHunterInRoom(ghost->currentRoom);
+    
+    // If there is a hunter in the room, reset the boredom timer and do not allow moving from a room
+    if (hunterInRoom) {
+        ghost->boredomTimer = 0;
+        ghostAction = randInt(0, GHOST_ACTION_COUNT - 1);
+    } else {
+        ghostAction = randInt(0, GHOST_ACTION_COUNT);
+        ghost->boredomTimer++;
+    }
+
+    // Perform the action
+    switch(ghostAction) {
+        case GHOST_MOVE_ROOM: 
+            PROFILE_BEGIN(PROF_GHOST_MOVE);
+            ghostMoveRoom(ghost);
+            PROFILE_END();
+            break;
+        case DROP_EVIDENCE:
+            PROFILE_BEGIN(PROF_GHOST_DROP);
+            if(config->dropBatch > 1) {
+                dropEvidenceBatch(ghost, config->dropBatch);
+            } else {
                 dropEvidence(ghost);
-                break;
-            default:
-                break;
-        }
+            }
+            PROFILE_END();
+            break;
+        default:
+            break;
     }
+    gameLeave(ghost->game);
+}
+
+/*  Function: ghostFinish()
+    Description: Logs why the ghost left and takes it out of the house
+
+    in/out: GhostType *ghost - Pointer to the GhostType struct that is leaving
     
+    Returns: None
+*/
+void ghostFinish(GhostType *ghost) {
+    gameEnter(ghost->game);
     // If the ghost is bored, exit
-    if(ghost->boredomTimer >= BOREDOM_MAX) {
+    if(ghost->boredomTimer >= ghost->config->boredomMax) {
         l_ghostExit(LOG_BORED);
+    } else if(isGameSolved(ghost->game)) {
+        l_ghostExit(LOG_EVIDENCE);
+    } else {
+        l_ghostExit(LOG_ALONE);
     }
 
     ghostExit(ghost);
-
-    return NULL;
+    ghost->exited = C_TRUE;
+    gameGhostLeft(ghost->game);
+    gameLeave(ghost->game);
 }
 
 /*  Function: ghostExit()
-    Description: Checks if there is a hunter in the room
+    Description: Removes the ghost from the room it is in
 
     in: GhostType *ghost - Pointer to the ghost that is leaving
     
     Returns: None
 */
 void ghostExit(GhostType *ghost) {
-    sem_wait(&ghost->currentRoom->roomSem);
-    ghost->currentRoom->ghost = NULL;
-    sem_post(&ghost->currentRoom->roomSem);
+    __atomic_sub_fetch(&ghost->currentRoom->ghostCount, 1, __ATOMIC_SEQ_CST);
 }
 
 /*  Function: checkIfHunterInRoom()
-    Description: Checks if there is a hunter in the room
+    Description: Checks if there is a hunter in the room, safe to call without the room's semaphore
 
     in: RoomType *room - Pointer to the RoomType struct to check
     
@@ -147,9 +221,7 @@ void ghostExit(GhostType *ghost) {
 */
 int checkIfHunterInRoom(RoomType *room) {
     if (!room) return C_FALSE; // Check for NULL pointer
-    HunterListType *hunterList = room->hunterList; 
-    int size = hunterList->size;
-    return size > 0;
+    return __atomic_load_n(&room->hunterCount, __ATOMIC_SEQ_CST) > 0;
 }
 
 /*  Function: moveRoom()
@@ -164,15 +236,13 @@ void ghostMoveRoom(GhostType *ghost) {
     RoomType *currRoom = ghost->currentRoom;
     // Find a random connected room
     RoomType *newRoom = findRandomConnectedRoom(currRoom);
+    if (!newRoom) return; // Check if the room has anywhere to go
 
-    lockSemaphors(&currRoom->roomSem, &newRoom->roomSem);
-    
-    // Update the ghost pointers for the rooms 
+    // A ghost is only ever in a room's atomic ghost count so neither room needs to be locked. It is counted
+    // in the new room before it leaves the old one so a hunter can never miss it mid move.
     ghost->currentRoom = newRoom;
-    newRoom->ghost = ghost;
-    currRoom->ghost = NULL;
-
-    unlockSemaphors(&currRoom->roomSem, &newRoom->roomSem);
+    __atomic_add_fetch(&newRoom->ghostCount, 1, __ATOMIC_SEQ_CST);
+    __atomic_sub_fetch(&currRoom->ghostCount, 1, __ATOMIC_SEQ_CST);
 
     l_ghostMove(newRoom->name);
 }
@@ -188,15 +258,52 @@ void dropEvidence(GhostType *ghost) {
     if (!ghost) return; // Check for NULL pointer
     
     // Finds a random piece of evidence in the ghosts possible evidence
-    sem_wait(&ghost->currentRoom->roomSem);
+    waitSemaphor(&ghost->currentRoom->roomSem);
     EvidenceType randEv = randomEvidence(ghost->evList);
-    // Add the evidence to the current room
-    addEvidence(ghost->currentRoom->evidenceList, randEv);
+    // Add the evidence to the current room, tagged with the ghost that left it, the oldest goes if it is full
+    addSourcedEvidence(ghost->currentRoom->evidenceList, randEv, ghost->id, gameTime(ghost->game));
+    expireRoomEvidence(ghost->currentRoom, ghost->game, ghost->config);
+    // Guided hunters read this without the room lock to pick where to go
+    __atomic_add_fetch(&ghost->currentRoom->evDrops[randEv], 1, __ATOMIC_RELAXED);
     sem_post(&ghost->currentRoom->roomSem);
+    gameEvidenceDropped(ghost->game, randEv, 1);
     
     l_ghostEvidence(randEv, ghost->currentRoom->name);
 }
 
+/*  Function: dropEvidenceBatch()
+    Description: Drops several random pieces of evidence in the current room while taking the room's
+                 semaphore once, and logs them as a single event
+
+    in: GhostType *ghost - Pointer to the GhostType struct to drop the evidence
+    in: int count - How many pieces of evidence to drop
+    
+    Returns: None
+*/
+void dropEvidenceBatch(GhostType *ghost, int count) {
+    if (!ghost || count <= 0) return; // Check for NULL pointer
+    RoomType *room = ghost->currentRoom;
+    int counts[EV_COUNT] = {0};
+
+    // Pick the evidence before taking the lock
+    for(int i = 0; i < count; i++) counts[randomEvidence(ghost->evList)]++;
+
+    waitSemaphor(&room->roomSem);
+    // Stamped once the lock is held so the batch is never older than evidence added while waiting for it
+    long long now = gameTime(ghost->game);
+    for(int ev = 0; ev < EV_COUNT; ev++) {
+        for(int i = 0; i < counts[ev]; i++) addSourcedEvidence(room->evidenceList, ev, ghost->id, now);
+        if(counts[ev] > 0) __atomic_add_fetch(&room->evDrops[ev], counts[ev], __ATOMIC_RELAXED);
+    }
+    expireRoomEvidence(room, ghost->game, ghost->config);
+    sem_post(&room->roomSem);
+
+    for(int ev = 0; ev < EV_COUNT; ev++) {
+        if(counts[ev] > 0) gameEvidenceDropped(ghost->game, ev, counts[ev]);
+    }
+    l_ghostEvidenceBatch(counts, room->name);
+}
+
 /*  Function: cleanupGhost()
     Description: Frees the memory allocated for the GhostType struct
 
@@ -209,3 +316,59 @@ void cleanupGhost(GhostType *ghost) {
     cleanupEvidenceList(ghost->evList);
     free(ghost);
 }
+
+/*  Function: createGhostList()
+    Description: Creates a new GhostListType struct and initializes its fields
+
+    in: None
+
+    Returns: GhostListType* - Pointer to the newly created GhostListType struct
+*/
+GhostListType* createGhostList() {
+    GhostListType *ghostList = safeMalloc(sizeof(GhostListType));
+    ghostList->size = 0;
+    // Enough for the default number of ghosts, addGhost grows it if more are created
+    ghostList->capacity = NUM_GHOSTS;
+    ghostList->ghosts = safeMalloc(sizeof(GhostType*) * ghostList->capacity);
+    return ghostList;
+}
+
+/*  Function: addGhost()
+    Description: Adds the ghost to the ghost list
+
+    in/out: GhostListType *dest - Pointer to the GhostListType struct to add to
+    in: GhostType *src - Pointer to the GhostType struct to add
+    
+    Returns: None
+*/
+void addGhost(GhostListType *dest, GhostType *src) {
+    if (!dest || !src) return; // Check for NULL pointers
+    // Double the array when it is full
+    if (dest->size == dest->capacity) {
+        dest->capacity *= 2;
+        dest->ghosts = realloc(dest->ghosts, sizeof(GhostType*) * dest->capacity);
+        if (!dest->ghosts) {
+            printf("Out of memory.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    dest->ghosts[dest->size] = src;
+    dest->size++;
+}
+
+/*  Function: cleanupGhostList()
+    Description: Frees the GhostListType struct and every ghost in it
+
+    in/out: GhostListType *ghostList - Pointer to the GhostListType struct to free
+    
+    Returns: None
+*/
+void cleanupGhostList(GhostListType *ghostList) {
+    if (!ghostList) return; // Check for NULL pointer
+    for(int i = 0; i < ghostList->size; i++) {
+        cleanupGhost(ghostList->ghosts[i]);
+    }
+
+    free(ghostList->ghosts);
+    free(ghostList);
+}
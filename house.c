@@ -14,6 +14,103 @@ void initHouse(HouseType **house) {
     (*house)->evidence = createEvidenceList();
     // This get initialized later on in the main method
     (*house)->hunterList = NULL;
+    (*house)->ghostList = createGhostList();
+    // These get built once all of the rooms have been added
+    (*house)->roomCount = 0;
+    (*house)->roomIndex = NULL;
+    (*house)->paths = NULL;
+    (*house)->game = createGameState();
+}
+
+// The last house a thread played in, its rooms and paths are reused by the thread's next game
+static __thread HouseType *cachedHouse = NULL;
+
+/*  Function: acquireHouse()
+    Description: Returns an empty house for a new game. The rooms, connections and path table of the
+                 calling thread's last house are reused, only the first game on a thread builds them.
+
+    out: HouseType **house - Pointer to the house to play in
+    
+    Returns: None
+*/
+void acquireHouse(HouseType **house) {
+    if (cachedHouse) {
+        *house = cachedHouse;
+        cachedHouse = NULL;
+        resetHouse(*house);
+        return;
+    }
+    initHouse(house);
+    populateRooms(*house);
+}
+
+/*  Function: releaseHouse()
+    Description: Frees the ghosts and hunters of a finished game and keeps the house for the
+                 thread's next acquireHouse()
+
+    in/out: HouseType *house - Pointer to the house the game was played in
+    
+    Returns: None
+*/
+void releaseHouse(HouseType *house) {
+    if (!house) return; // Check for NULL pointer
+    if (cachedHouse) {
+        cleanupHouse(house);
+        return;
+    }
+
+    for(int i = 0; i < house->ghostList->size; i++) cleanupGhost(house->ghostList->ghosts[i]);
+    house->ghostList->size = 0;
+    cleanupHunterList(house->hunterList);
+    house->hunterList = NULL;
+    cachedHouse = house;
+}
+
+/*  Function: resetHouse()
+    Description: Clears everything a game left in the house, the layout is kept
+
+    in/out: HouseType *house - Pointer to the house to reset
+    
+    Returns: None
+*/
+void resetHouse(HouseType *house) {
+    if (!house) return; // Check for NULL pointer
+    for(int i = 0; i < house->roomCount; i++) resetRoom(house->roomIndex[i]);
+    clearEvidenceList(house->evidence);
+    resetGameState(house->game);
+}
+
+/*  Function: cleanupHouseCache()
+    Description: Frees the house kept by releaseHouse(), called by every thread that played games
+                 before it ends
+    
+    Returns: None
+*/
+void cleanupHouseCache() {
+    cleanupHouse(cachedHouse);
+    cachedHouse = NULL;
+}
+
+/*  Function: indexHouse()
+    Description: Gives every room an index into the house and builds the shortest path table
+
+    in/out: HouseType *house - Pointer to the HouseType struct to index
+    
+    Returns: None
+*/
+void indexHouse(HouseType *house) {
+    if (!house) return; // Check for NULL pointer
+    house->roomCount = house->rooms->size;
+    house->roomIndex = safeMalloc(sizeof(RoomType*) * house->roomCount);
+
+    RoomNodeType *currRoom = house->rooms->head;
+    for(int i = 0; i < house->roomCount; i++) {
+        currRoom->data->id = i;
+        house->roomIndex[i] = currRoom->data;
+        currRoom = currRoom->next;
+    }
+
+    house->paths = buildPathTable(house);
 }
 
 /*  Function: randomRoomInHouse()
@@ -43,10 +140,15 @@ RoomType* randomRoomInHouse(HouseType *house) {
     Returns: None
 */
 void cleanupHouse(HouseType *house) {
+    if (!house) return; // Check for NULL pointer
     cleanupHunterList(house->hunterList);
+    cleanupGhostList(house->ghostList);
     cleanupRoomListData(house->rooms);
     cleanupRoomList(house->rooms);
     cleanupEvidenceList(house->evidence);
+    cleanupPathTable(house->paths);
+    cleanupGameState(house->game);
+    free(house->roomIndex);
     free(house);
 }
 
@@ -105,4 +207,7 @@ void populateRooms(HouseType* house) {
     addRoom(&house->rooms, living_room);
     addRoom(&house->rooms, garage);
     addRoom(&house->rooms, utility_room);
+
+    // The layout is final so the paths between rooms can be computed once
+    indexHouse(house);
 }
@@ -4,29 +4,58 @@
     Description: Creates a new HunterType struct and initializes its fields
 
     in/out: HunterType **hunter - Pointer to the newly created HunterType struct
-    in: GhostType *ghost - Pointer to the GhostType struct to add the hunter to
+    in: GhostListType *ghosts - The ghosts haunting the house that the hunter has to identify
     in: HouseType *house - Pointer to the HouseType struct to add the hunter to
     in: char name[] - The name of the hunter
     in/out: id - The id of the current hunter that will be decremented 
     in: ev - The type of evidence the hunter is able to pick up 
+    in: config - The simulation parameters, including how the hunter picks the next room to move into
     
     Returns: None
 */
-void initHunter(HunterType **hunter, GhostType *ghost, HouseType *house, char name[], int *id, EvidenceType ev) {
+void initHunter(HunterType **hunter, GhostListType *ghosts, HouseType *house, char name[], int *id, EvidenceType ev, const ConfigType *config) {
     (*hunter) = safeMalloc(sizeof(HunterType));
     strcpy((*hunter)->name, name);
     (*hunter)->evidence = ev;
     (*hunter)->fear = 0;
     (*hunter)->boredom = 0;
+    (*hunter)->fearMax = config->fearMax;
+    (*hunter)->boredomMax = config->boredomMax;
     // The first room in the house is the van
     (*hunter)->room = house->rooms->head->data;
+    roomAddHunter((*hunter)->room, *hunter);
+    (*hunter)->moving = C_FALSE;
     (*hunter)->id = *id;
     (*id)--;
     (*hunter)->sharedEv = house->evidence;
-    (*hunter)->ghostEv = ghost->evList;
+    (*hunter)->ghosts = ghosts;
+    // Nothing has been reviewed yet, foundEv holds a bit per evidence type for each ghost id
+    (*hunter)->reviewedGen = -1;
+    (*hunter)->reviewedTail = NULL;
+    (*hunter)->foundEv = safeMalloc(sizeof(int) * (ghosts->size > 0 ? ghosts->size : 1));
+    for(int i = 0; i < ghosts->size; i++) (*hunter)->foundEv[i] = 0;
     (*hunter)->allHunters = house->hunterList;
     // This will make logging game completion simpler 
     (*hunter)->sufficientEv = C_FALSE;
+
+    // Movement state used by the guided policies
+    (*hunter)->house = house;
+    (*hunter)->policy = config->policy;
+    (*hunter)->moves = 0;
+    (*hunter)->visitedAt = safeMalloc(sizeof(int) * house->roomCount);
+    (*hunter)->seenDrops = safeMalloc(sizeof(int) * house->roomCount);
+    for(int i = 0; i < house->roomCount; i++) {
+        (*hunter)->visitedAt[i] = -1;
+        (*hunter)->seenDrops[i] = 0;
+    }
+    markVisited(*hunter, (*hunter)->room);
+
+    (*hunter)->config = config;
+    (*hunter)->ticks = 0;
+    (*hunter)->exitReason = LOG_UNKNOWN;
+    (*hunter)->seed = newRandomSeed();
+    (*hunter)->game = house->game;
+    gameHunterJoined((*hunter)->game);
     l_hunterInit(name, ev);
 }
 
@@ -40,6 +69,9 @@ void initHunter(HunterType **hunter, GhostType *ghost, HouseType *house, char na
 HunterListType* createHunterList() {
     HunterListType *hunterList = safeMalloc(sizeof(HunterListType));
     hunterList->size = 0;
+    // Enough for the default number of hunters, addHunter grows it if more join
+    hunterList->capacity = NUM_HUNTERS;
+    hunterList->hunters = safeMalloc(sizeof(HunterType*) * hunterList->capacity);
     return hunterList;
 }
 
@@ -66,60 +98,131 @@ pthread_t* startHunterThread(HunterType *hunter) {
 void *hunterLogic(void *hunterPtr) {
     HunterType *hunter = (HunterType*) hunterPtr;
     
-    // Only loop as long as they are not too bored or scared 
-    while(hunter->boredom < BOREDOM_MAX && hunter->fear < FEAR_MAX) {
-        usleep(HUNTER_WAIT);
-        
-        // Check if the ghost is in the room
-        sem_wait(&hunter->room->roomSem);
-        int ghostInRoom = hunter->room->ghost != NULL;
-        sem_post(&hunter->room->roomSem);
-
-        if(ghostInRoom) {
-            hunter->fear++;
-            hunter->boredom = 0;
-        } else {
-            hunter->boredom++;
-        }
+    const ConfigType *config = hunter->config;
+    useRandomSeed(&hunter->seed);
+    PROFILE_THREAD_START();
+    
+    while(hunterActive(hunter)) {
+        PROFILE_BEGIN(PROF_SLEEP);
+        simSleep(hunter->game, config->hunterWait);
+        PROFILE_END();
+        if(!hunterStep(hunter)) break;
+    }
 
-        // Perform a random action
-        HunterActionType hunterAction = randInt(0, HUNTER_ACTION_COUNT);
-        int sufficient = C_FALSE;
-        switch(hunterAction) {
-            case HUNTER_MOVE_ROOM: 
-                moveRoomHunt(hunter);
-                break;
-            case COLLECT_EV:
-                collectEvidence(hunter);
-                break;
-            case REVIEW:
-                sufficient = review(hunter);
-                break;
-            default:
-                break;
-        }
+    hunterFinish(hunter);
+    gameClockLeave(hunter->game);
+    PROFILE_THREAD_DONE();
+
+    return NULL;
+}
+
+/*  Function: hunterActive()
+    Description: Checks if the hunter should keep hunting
+
+    in: HunterType *hunter - Pointer to the HunterType struct to check
+    
+    Returns: int - C_TRUE as long as they are not too bored or scared and nobody has solved the case yet
+*/
+int hunterActive(HunterType *hunter) {
+    return hunter->boredom < hunter->boredomMax && hunter->fear < hunter->fearMax && !isHuntOver(hunter->game);
+}
+
+/*  Function: hunterStep()
+    Description: Performs one turn of the hunter, the caller is responsible for waiting between turns
+                 and for making the hunter's seed the calling thread's random state
+
+    in/out: HunterType *hunter - Pointer to the HunterType struct to act
+    
+    Returns: int - C_FALSE if the hunter found sufficient evidence, it is then still inside the pause lock
+*/
+int hunterStep(HunterType *hunter) {
+    const ConfigType *config = hunter->config;
+    gameEnter(hunter->game);
+    hunter->ticks++;
+    
+    // Check if a ghost is in the room
+    int ghostInRoom = __atomic_load_n(&hunter->room->ghostCount, __ATOMIC_SEQ_CST) > 0;
+
+    if(ghostInRoom) {
+        hunter->fear++;
+        hunter->boredom = 0;
+    } else {
+        hunter->boredom++;
+    }
 
-        if(sufficient) {
-            hunter->sufficientEv = C_TRUE;
-            l_hunterExit(hunter->name, LOG_EVIDENCE);
+    // Perform a random action
+    HunterActionType hunterAction = randInt(0, HUNTER_ACTION_COUNT);
+    int sufficient = C_FALSE;
+    switch(hunterAction) {
+        case HUNTER_MOVE_ROOM: 
+            PROFILE_BEGIN(PROF_HUNTER_MOVE);
+            moveRoomHunt(hunter);
+            PROFILE_END();
+            break;
+        case COLLECT_EV:
+            PROFILE_BEGIN(PROF_HUNTER_COLLECT);
+            if(config->collectAll) {
+                collectAllEvidence(hunter);
+            } else {
+                collectEvidence(hunter);
+            }
+            PROFILE_END();
+            break;
+        case REVIEW:
+            PROFILE_BEGIN(PROF_HUNTER_REVIEW);
+            sufficient = review(hunter);
+            PROFILE_END();
+            break;
+        default:
             break;
-        }
+    }
+
+    if(sufficient) {
+        hunter->sufficientEv = C_TRUE;
+        gameSolved(hunter->game);
+        return C_FALSE;
+    }
+    gameLeave(hunter->game);
+    return C_TRUE;
+}
+
+/*  Function: hunterFinish()
+    Description: Logs why the hunter left and takes them out of the house
+
+    in/out: HunterType *hunter - Pointer to the HunterType struct that is leaving
+    
+    Returns: None
+*/
+void hunterFinish(HunterType *hunter) {
+    // A hunter that found sufficient evidence is still inside the pause lock
+    if(!hunter->sufficientEv) gameEnter(hunter->game);
+    if(hunter->sufficientEv) {
+        hunter->exitReason = LOG_EVIDENCE;
+        l_hunterExit(hunter->name, LOG_EVIDENCE);
+    }
+
+    // Another hunter already found sufficient evidence so there is no reason to stay
+    if(!hunter->sufficientEv && hunter->boredom < hunter->boredomMax && hunter->fear < hunter->fearMax) {
+        hunter->exitReason = LOG_EVIDENCE;
+        l_hunterExit(hunter->name, LOG_EVIDENCE);
     }
 
     
     // Check if the hunter is bored or scared
-    if(hunter->boredom >= BOREDOM_MAX) {
+    if(hunter->boredom >= hunter->boredomMax) {
+        hunter->exitReason = LOG_BORED;
         l_hunterExit(hunter->name, LOG_BORED);
     }
 
-    if(hunter->fear >= FEAR_MAX) {
+    if(hunter->fear >= hunter->fearMax) {
+        hunter->exitReason = LOG_FEAR;
         l_hunterExit(hunter->name, LOG_FEAR);
     }
 
     // Remove the hunter from the room's hunter list
     hunterExit(hunter);
-
-    return NULL;
+    gameHunterLeft(hunter->game);
+    gameLeave(hunter->game);
 }
 
 /*  Function: hunterExit()
@@ -131,8 +234,8 @@ void *hunterLogic(void *hunterPtr) {
 */
 void hunterExit(HunterType *hunter) {
     if (!hunter || !hunter->room) return; // Check for NULL pointers
-    sem_wait(&hunter->room->roomSem);
-    delHunter(hunter->room->hunterList, hunter->id);
+    waitSemaphor(&hunter->room->roomSem);
+    roomRemoveHunter(hunter->room, hunter);
     sem_post(&hunter->room->roomSem);
 }
 
@@ -147,16 +250,94 @@ void moveRoomHunt(HunterType *hunter) {
     if (!hunter || !hunter->room) return; // Check for NULL pointers
 
     RoomType *currRoom = hunter->room;
-    RoomType *newRoom = findRandomConnectedRoom(currRoom);
+    RoomType *newRoom = chooseHunterRoom(hunter);
     
     if (!newRoom) return; // Check if new room selection was successful
 
-    lockSemaphors(&newRoom->roomSem, &currRoom->roomSem);
+    // Only one room is locked at a time, leaving first since the hunter's slot is the one in the room it is in.
+    // Between the two the hunter is in neither room and marked as moving so the stress checker can tell.
+    waitSemaphor(&currRoom->roomSem);
+    roomRemoveHunter(currRoom, hunter);
+    hunter->moving = C_TRUE;
+    sem_post(&currRoom->roomSem);
+    if(hunter->config->stress > 0) stressInTransit();
+
+    waitSemaphor(&newRoom->roomSem);
     hunter->room = newRoom;
-    addHunter(newRoom->hunterList, hunter);
-    delHunter(currRoom->hunterList, hunter->id);
+    roomAddHunter(newRoom, hunter);
+    hunter->moving = C_FALSE;
+    sem_post(&newRoom->roomSem);
     l_hunterMove(hunter->name, newRoom->name);
-    unlockSemaphors(&newRoom->roomSem, &currRoom->roomSem);
+
+    __atomic_add_fetch(&newRoom->visits, 1, __ATOMIC_RELAXED);
+    markVisited(hunter, newRoom);
+}
+
+/*  Function: chooseHunterRoom()
+    Description: Picks the connected room the hunter moves into next based on its policy.
+                 MOVE_EXPLORE heads for the least recently visited room (never visited first),
+                 MOVE_EVIDENCE heads for the closest room where the ghost has dropped evidence
+                 of the hunter's type since the hunter was last there and explores otherwise.
+
+    in: HunterType *hunter - Pointer to the HunterType struct that is moving
+    
+    Returns: RoomType* - Pointer to the connected room to move into
+*/
+RoomType* chooseHunterRoom(HunterType *hunter) {
+    if (!hunter || !hunter->room) return NULL; // Check for NULL pointers
+    HouseType *house = hunter->house;
+    if (hunter->policy == MOVE_RANDOM || !house || !house->paths) {
+        return findRandomConnectedRoom(hunter->room);
+    }
+
+    int from = hunter->room->id;
+    int target = -1;
+    int targetDist = 0;
+
+    // Look for the closest room with fresh evidence the hunter can collect
+    if (hunter->policy == MOVE_EVIDENCE) {
+        for(int i = 0; i < house->roomCount; i++) {
+            int drops = __atomic_load_n(&house->roomIndex[i]->evDrops[hunter->evidence], __ATOMIC_RELAXED);
+            int dist = pathDistance(house->paths, from, i);
+            if(i == from || dist < 0 || drops <= hunter->seenDrops[i]) continue;
+
+            if(target < 0 || dist < targetDist) {
+                target = i;
+                targetDist = dist;
+            }
+        }
+    }
+
+    // Otherwise go to the least recently visited room, breaking ties by distance
+    if (target < 0) {
+        for(int i = 0; i < house->roomCount; i++) {
+            int dist = pathDistance(house->paths, from, i);
+            if(i == from || dist < 0) continue;
+
+            if(target < 0 || hunter->visitedAt[i] < hunter->visitedAt[target] || 
+                (hunter->visitedAt[i] == hunter->visitedAt[target] && dist < targetDist)) {
+                target = i;
+                targetDist = dist;
+            }
+        }
+    }
+
+    if (target < 0) return findRandomConnectedRoom(hunter->room);
+    return pathNextRoom(house, hunter->room, house->roomIndex[target]);
+}
+
+/*  Function: markVisited()
+    Description: Records that the hunter is in the room for the guided movement policies
+
+    in/out: HunterType *hunter - Pointer to the HunterType struct that entered the room
+    in: RoomType *room - Pointer to the room that was entered
+    
+    Returns: None
+*/
+void markVisited(HunterType *hunter, RoomType *room) {
+    if (!hunter || !room || !hunter->visitedAt || room->id < 0) return; // Check for NULL pointers
+    hunter->visitedAt[room->id] = hunter->moves++;
+    hunter->seenDrops[room->id] = __atomic_load_n(&room->evDrops[hunter->evidence], __ATOMIC_RELAXED);
 }
 
 /*  Function: collectEvidence()
@@ -170,8 +351,12 @@ void collectEvidence(HunterType *hunter) {
     if (!hunter || !hunter->room || !hunter->room->evidenceList || !hunter->sharedEv) return; // Check for NULL pointers
     lockSemaphors(&hunter->sharedEv->evSem, &hunter->room->roomSem);
 
+    // Evidence that has decayed can no longer be found
+    expireRoomEvidence(hunter->room, hunter->game, hunter->config);
+
     // This will return the evidence or unknown if there isn't that type of evidence in the list 
-    EvidenceType ev = removeEvidence(hunter->room->evidenceList, hunter->evidence);
+    int source;
+    EvidenceType ev = takeEvidence(hunter->room->evidenceList, hunter->evidence, &source);
     sem_post(&hunter->room->roomSem);
 
     // Check if the evidence is unknown
@@ -180,41 +365,90 @@ void collectEvidence(HunterType *hunter) {
         return;
     }
     
-    // Add the evidence to the hunter's shared list
-    addEvidence(hunter->sharedEv, ev); 
+    // Add the evidence to the hunter's shared list, keeping track of which ghost left it
+    addSourcedEvidence(hunter->sharedEv, ev, source, gameTime(hunter->game));
     sem_post(&hunter->sharedEv->evSem);
+    gameEvidenceCollected(hunter->game, ev, 1);
     l_hunterCollect(hunter->name, hunter->evidence, hunter->room->name);
 }
 
+/*  Function: collectAllEvidence()
+    Description: Collects every piece of the hunter's evidence type in the room at once and logs
+                 them as a single event
+
+    in/out: HunterType *hunter - Pointer to the HunterType struct to collect the evidence
+    
+    Returns: None
+*/
+void collectAllEvidence(HunterType *hunter) {
+    if (!hunter || !hunter->room || !hunter->room->evidenceList || !hunter->sharedEv) return; // Check for NULL pointers
+    lockSemaphors(&hunter->sharedEv->evSem, &hunter->room->roomSem);
+    expireRoomEvidence(hunter->room, hunter->game, hunter->config);
+    int count = moveAllEvidence(hunter->room->evidenceList, hunter->sharedEv, hunter->evidence);
+    unlockSemaphors(&hunter->sharedEv->evSem, &hunter->room->roomSem);
+
+    if(count == 0) return;
+    gameEvidenceCollected(hunter->game, hunter->evidence, count);
+
+    // A single piece is logged the same way as collectEvidence() does
+    if(count == 1) {
+        l_hunterCollect(hunter->name, hunter->evidence, hunter->room->name);
+    } else {
+        l_hunterCollectBatch(hunter->name, hunter->evidence, count, hunter->room->name);
+    }
+}
+
 /*  Function: review()
-    Description: Checks if the hunter has collected sufficient evidence
+    Description: Checks if the hunter has collected sufficient evidence. Evidence only counts towards
+                 the ghost that left it, and the class of each ghost is deduced from its evidence without
+                 looking at the ghost. A ghost is identified once the deduction reaches config->confidence
+                 percent or config->evPerGhost types were found, the hunters are done once every ghost is.
+                 The shared list only grows at its tail during a game, so the hunter remembers the last node
+                 and generation it reviewed and only looks at evidence that was added since then.
 
     in: HunterType *hunter - Pointer to the HunterType struct to check
     
     Returns: int - 1 if the hunter has collected sufficient evidence, 0 otherwise
 */
 int review(HunterType *hunter) {
-    if (!hunter || !hunter->ghostEv || !hunter->sharedEv) return C_FALSE; // Check for NULL pointers
-    sem_wait(&hunter->sharedEv->evSem);
-    EvidenceNodeType *currNode = hunter->ghostEv->head;
-    int foundCounter = 0;
-
-    // Loop through the hunter's evidence list
-    for(int i = 0; i < hunter->ghostEv->size; i++) {
-        EvidenceNodeType *currFoundEvNode = hunter->sharedEv->head;
-        for(int j = 0; j < hunter->sharedEv->size; j++) {
-            if(currFoundEvNode->data == currNode->data) {
-                foundCounter++;
-                break;
+    if (!hunter || !hunter->ghosts || !hunter->sharedEv) return C_FALSE; // Check for NULL pointers
+    GhostListType *ghosts = hunter->ghosts;
+    EvidenceListType *shared = hunter->sharedEv;
+    int identified = 0;
+
+    // Only take the lock when something was collected since the last review
+    int generation = __atomic_load_n(&shared->generation, __ATOMIC_ACQUIRE);
+    if(generation != hunter->reviewedGen) {
+        waitSemaphor(&shared->evSem);
+        EvidenceNodeType *currNode = hunter->reviewedTail ? hunter->reviewedTail->next : shared->head;
+        while(currNode) {
+            if(currNode->source >= 0 && currNode->source < ghosts->size) {
+                hunter->foundEv[currNode->source] |= 1 << currNode->data;
             }
-            currFoundEvNode = currFoundEvNode->next;
+            hunter->reviewedTail = currNode;
+            currNode = currNode->next;
         }
-        currNode = currNode->next;
+        hunter->reviewedGen = shared->generation;
+        sem_post(&shared->evSem);
     }
-    sem_post(&hunter->sharedEv->evSem);
 
-    // Check if the hunter has found all the evidence
-    if(foundCounter == 3) {
+    for(int g = 0; g < ghosts->size; g++) {
+        GhostType *ghost = ghosts->ghosts[g];
+        int found = hunter->foundEv[ghost->id];
+        int confidence;
+        // A replayed review only has to come out the same, which class wins a tie does not change that
+        GhostClass deduced = deduceGhost(found, &confidence, !hunter->game->replaying);
+
+        // Check if the hunters are sure enough of what this ghost is
+        if(confidence >= hunter->config->confidence || countBits(found) >= hunter->config->evPerGhost) {
+            __atomic_store_n(&ghost->deduced, deduced, __ATOMIC_RELAXED);
+            __atomic_store_n(&ghost->confidence, confidence, __ATOMIC_RELAXED);
+            __atomic_store_n(&ghost->identified, C_TRUE, __ATOMIC_RELAXED);
+            identified++;
+        }
+    }
+
+    if(identified == ghosts->size) {
         l_hunterReview(hunter->name, LOG_SUFFICIENT);
         return C_TRUE;
     }
@@ -233,6 +467,15 @@ int review(HunterType *hunter) {
 */
 void addHunter(HunterListType *dest, HunterType *src) {
     if (!dest || !src) return; // Check for NULL pointers
+    // Double the array when it is full
+    if (dest->size == dest->capacity) {
+        dest->capacity *= 2;
+        dest->hunters = realloc(dest->hunters, sizeof(HunterType*) * dest->capacity);
+        if (!dest->hunters) {
+            printf("Out of memory.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
     dest->hunters[dest->size] = src;
     dest->size++;
 }
@@ -270,6 +513,21 @@ int delHunter(HunterListType *src, int hunterId) {
     return C_FALSE; 
 }
 
+/*  Function: cleanupHunter()
+    Description: Frees all dynamically allocated memory in the HunterType struct
+
+    in/out: HunterType *hunter - Pointer to the HunterType struct to free
+    
+    Returns: None
+*/
+void cleanupHunter(HunterType *hunter) {
+    if (!hunter) return; // Check for NULL pointer
+    free(hunter->visitedAt);
+    free(hunter->seenDrops);
+    free(hunter->foundEv);
+    free(hunter);
+}
+
 /*  Function: cleanupHunterList()
     Description: Frees all dynamically allocated memory in the HunterListType struct
 
@@ -281,8 +539,9 @@ void cleanupHunterList(HunterListType *hunterList) {
     if (!hunterList) return; // Check for NULL pointer
     // Free all the hunters
     for(int i = 0; i < hunterList->size; i++) {
-        free(hunterList->hunters[i]);
+        cleanupHunter(hunterList->hunters[i]);
     }
 
+    free(hunterList->hunters);
     free(hunterList);
 }
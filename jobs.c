@@ -0,0 +1,197 @@
+#include "defs.h"
+
+/*
+    Batches can be split over parallel jobs, each a thread that plays its share of the games one
+    after another. With --cpus every job is pinned to its own slice of the listed CPUs before it builds
+    a house. The game threads it starts inherit the pinning, and since Linux places memory on the node
+    of the CPU that first touches it, the job's house and rooms end up on the job's own node.
+*/
+
+// One job of a batch
+typedef struct {
+    int id;
+    int jobs;
+    const ConfigType *config;
+    int pinned;
+    cpu_set_t cpus;
+    StatsType stats;
+} JobType;
+
+/*  Function: parseCpuList()
+    Description: Reads a list of CPUs like "0-3,8,10-11"
+
+    in: const char *list - The list to read
+    out: cpu_set_t *set - The CPUs in the list
+
+    Returns: int - C_TRUE if the list was valid and not empty, C_FALSE otherwise
+*/
+int parseCpuList(const char *list, cpu_set_t *set) {
+    CPU_ZERO(set);
+    const char *pos = list;
+
+    while(*pos) {
+        char *end;
+        long from = strtol(pos, &end, 10);
+        long to = from;
+        if(end == pos || from < 0) return C_FALSE;
+        if(*end == '-') {
+            pos = end + 1;
+            to = strtol(pos, &end, 10);
+            if(end == pos || to < from) return C_FALSE;
+        }
+        if(to >= CPU_SETSIZE) return C_FALSE;
+        for(long cpu = from; cpu <= to; cpu++) CPU_SET(cpu, set);
+
+        if(*end == ',') end++;
+        else if(*end != '\0') return C_FALSE;
+        pos = end;
+    }
+
+    return CPU_COUNT(set) > 0;
+}
+
+/*  Function: describeCpuSet()
+    Description: Writes a set of CPUs as a list like "0-3,8", the inverse of parseCpuList()
+
+    in: const cpu_set_t *set - The CPUs to describe
+    out: char *buffer - The list
+    in: size_t size - The size of the buffer
+
+    Returns: None
+*/
+void describeCpuSet(const cpu_set_t *set, char *buffer, size_t size) {
+    size_t len = 0;
+    buffer[0] = '\0';
+    for(int cpu = 0; cpu < CPU_SETSIZE && len < size; cpu++) {
+        if(!CPU_ISSET(cpu, set)) continue;
+        int last = cpu;
+        while(last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, set)) last++;
+        if(last == cpu) {
+            len += snprintf(buffer + len, size - len, "%s%d", len > 0 ? "," : "", cpu);
+        } else {
+            len += snprintf(buffer + len, size - len, "%s%d-%d", len > 0 ? "," : "", cpu, last);
+        }
+        cpu = last;
+    }
+}
+
+/*  Function: cpuNode()
+    Description: Finds the NUMA node a CPU belongs to from sysfs
+
+    in: int cpu - The CPU to look up
+
+    Returns: int - The node, -1 if the system does not say
+*/
+static int cpuNode(int cpu) {
+    char path[MAX_PATH];
+    for(int node = 0; node < 64; node++) {
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/node%d", cpu, node);
+        if(access(path, F_OK) == 0) return node;
+    }
+    return -1;
+}
+
+/*  Function: sliceCpus()
+    Description: Gives a job an equal share of the CPUs in order, jobs share CPUs when there are more jobs than CPUs
+
+    in: const cpu_set_t *all - Every CPU the batch may use
+    in: int jobs - The number of jobs
+    in: int job - The job to find the share of
+    out: cpu_set_t *slice - The job's CPUs
+
+    Returns: None
+*/
+static void sliceCpus(const cpu_set_t *all, int jobs, int job, cpu_set_t *slice) {
+    int count = CPU_COUNT(all);
+    int from = (int) ((long) job * count / jobs);
+    int to = (int) ((long) (job + 1) * count / jobs);
+    if(to == from) {
+        from = job % count;
+        to = from + 1;
+    }
+
+    CPU_ZERO(slice);
+    int rank = 0;
+    for(int cpu = 0; cpu < CPU_SETSIZE && rank < to; cpu++) {
+        if(!CPU_ISSET(cpu, all)) continue;
+        if(rank >= from) CPU_SET(cpu, slice);
+        rank++;
+    }
+}
+
+/*  Function: runJob()
+    Description: The main logic for a job thread, pins itself and plays every jobs-th game of the batch
+
+    in/out: void *jobPtr - Pointer to the JobType struct to run
+    
+    Returns: void* - NULL
+*/
+static void *runJob(void *jobPtr) {
+    JobType *job = (JobType*) jobPtr;
+
+    if(job->pinned) {
+        // Report where the job landed, the nodes are the ones its memory is placed on
+        char cpus[MAX_PATH];
+        char nodes[MAX_STR] = "";
+        unsigned long long seen = 0;
+        describeCpuSet(&job->cpus, cpus, sizeof(cpus));
+        if(pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &job->cpus) != 0) {
+            printf("[PLACEMENT] job %d: could not pin to cpus %s, running unpinned\n", job->id, cpus);
+            job->pinned = C_FALSE;
+        }
+        for(int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            int node = CPU_ISSET(cpu, &job->cpus) ? cpuNode(cpu) : -1;
+            if(node < 0 || (seen >> node) & 1) continue;
+            seen |= 1ULL << node;
+            snprintf(nodes + strlen(nodes), sizeof(nodes) - strlen(nodes), "%s%d", nodes[0] ? "," : "", node);
+        }
+        if(job->pinned) {
+            printf("[PLACEMENT] job %d: cpus %s, node %s, running on cpu %d\n", job->id, cpus, nodes[0] ? nodes : "unknown", sched_getcpu());
+        }
+    }
+
+    for(int game = job->id; game < job->config->games; game += job->jobs) {
+        runGame(job->config, &job->stats);
+    }
+    cleanupHouseCache();
+    return NULL;
+}
+
+/*  Function: runJobs()
+    Description: Plays config->games games split over config->jobs parallel jobs, pinned to slices of
+                 config->cpuList when it is set, and adds every game to the stats
+
+    in: const ConfigType *config - The parameters to play the games with
+    in/out: StatsType *stats - The aggregate the jobs' games are merged into
+
+    Returns: None
+*/
+void runJobs(const ConfigType *config, StatsType *stats) {
+    int jobCount = config->jobs < config->games ? config->jobs : config->games;
+    JobType *jobs = safeMalloc(sizeof(JobType) * jobCount);
+    pthread_t *threads = safeMalloc(sizeof(pthread_t) * jobCount);
+    cpu_set_t all;
+    int pinned = config->cpuList[0] != '\0' && parseCpuList(config->cpuList, &all);
+
+    for(int i = 0; i < jobCount; i++) {
+        JobType *job = &jobs[i];
+        job->id = i;
+        job->jobs = jobCount;
+        job->config = config;
+        job->pinned = pinned;
+        if(pinned) sliceCpus(&all, jobCount, i, &job->cpus);
+        initStats(&job->stats, stats->csv);
+        job->stats.csvFirst = i;
+        job->stats.csvStride = jobCount;
+        pthread_create(&threads[i], NULL, runJob, job);
+    }
+
+    for(int i = 0; i < jobCount; i++) {
+        pthread_join(threads[i], NULL);
+        mergeStats(stats, &jobs[i].stats);
+        cleanupStats(&jobs[i].stats);
+    }
+
+    free(threads);
+    free(jobs);
+}
@@ -1,19 +1,283 @@
 #include "defs.h"
 
+static int logEnabled = LOGGING;
+// Kept open between events, every line is written with a single call so lines from different threads never mix
+static FILE *logFile = NULL;
+
+#define LOG_LINE_MAX    (MAX_STR * 6)
+
+// A log line is assembled here from pre-rendered fragments before it is written out
+typedef struct {
+    char buf[LOG_LINE_MAX];
+    int len;
+} LogLineType;
+
+// Tags pre-padded to the 17 characters of "%-17s" plus the space that follows them
+#define LOG_TAG(tag)    { tag, sizeof(tag) - 1 }
+typedef struct {
+    const char *text;
+    int len;
+} LogFragmentType;
+
+static const LogFragmentType TAG_HUNTER_INIT     = LOG_TAG("[HUNTER INIT]     ");
+static const LogFragmentType TAG_HUNTER_MOVE     = LOG_TAG("[HUNTER MOVE]     ");
+static const LogFragmentType TAG_HUNTER_EXIT     = LOG_TAG("[HUNTER EXIT]     ");
+static const LogFragmentType TAG_HUNTER_REVIEW   = LOG_TAG("[HUNTER REVIEW]   ");
+static const LogFragmentType TAG_HUNTER_EVIDENCE = LOG_TAG("[HUNTER EVIDENCE] ");
+static const LogFragmentType TAG_GHOST_INIT      = LOG_TAG("[GHOST INIT]      ");
+static const LogFragmentType TAG_GHOST_MOVE      = LOG_TAG("[GHOST MOVE]      ");
+static const LogFragmentType TAG_GHOST_EXIT      = LOG_TAG("[GHOST EXIT]      ");
+static const LogFragmentType TAG_GHOST_EVIDENCE  = LOG_TAG("[GHOST EVIDENCE]  ");
+
+// Indexed by EvidenceType, EV_COUNT and EV_UNKNOWN both print as UNKNOWN like evidenceName()
+static const LogFragmentType evidenceNames[] = {
+    LOG_TAG("EMF"), LOG_TAG("TEMPERATURE"), LOG_TAG("FINGERPRINTS"), LOG_TAG("SOUND"), LOG_TAG("UNKNOWN"), LOG_TAG("UNKNOWN")
+};
+
+// Indexed by LoggerDetails, including the newline that ends the line
+static const LogFragmentType reasonNames[] = {
+    LOG_TAG("[FEAR]\n"), LOG_TAG("[BORED]\n"), LOG_TAG("[EVIDENCE]\n"), LOG_TAG("[SUFFICIENT]\n"),
+    LOG_TAG("[INSUFFICIENT]\n"), LOG_TAG("[ALONE]\n"), LOG_TAG("[UNKNOWN]\n")
+};
+
+/*
+    Appends bytes to a log line, anything past the end of the buffer is dropped.
+    in/out: line - the line being assembled
+    in: text - the bytes to append
+    in: len - how many bytes to append
+*/
+static void lineAppend(LogLineType *line, const char *text, int len) {
+    if (line->len + len > LOG_LINE_MAX) len = LOG_LINE_MAX - line->len;
+    memcpy(line->buf + line->len, text, len);
+    line->len += len;
+}
+
+/*
+    Appends a pre-rendered fragment to a log line.
+    in/out: line - the line being assembled
+    in: fragment - the fragment to append
+*/
+static void lineFragment(LogLineType *line, const LogFragmentType *fragment) {
+    lineAppend(line, fragment->text, fragment->len);
+}
+
+/*
+    Appends a name wrapped in square brackets to a log line.
+    in/out: line - the line being assembled
+    in: name - the name to append
+*/
+static void lineName(LogLineType *line, const char *name) {
+    lineAppend(line, "[", 1);
+    lineAppend(line, name, strlen(name));
+    lineAppend(line, "]", 1);
+}
+
+/*
+    Appends a non-negative number to a log line.
+    in/out: line - the line being assembled
+    in: value - the number to append
+*/
+static void lineInt(LogLineType *line, int value) {
+    char digits[16];
+    int len = 0;
+    do {
+        digits[sizeof(digits) - 1 - len++] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0 && len < (int) sizeof(digits));
+    lineAppend(line, digits + sizeof(digits) - len, len);
+}
+
+/*
+    Appends the reason a log line ends with, reasons not in the allowed set print as [UNKNOWN].
+    in/out: line - the line being assembled
+    in: reason - the reason to append
+    in: allowed - bit mask of the LoggerDetails values the event can report
+*/
+static void lineReason(LogLineType *line, enum LoggerDetails reason, int allowed) {
+    if (reason < 0 || reason >= LOG_UNKNOWN || !((allowed >> reason) & 1)) reason = LOG_UNKNOWN;
+    lineFragment(line, &reasonNames[reason]);
+}
+
+/*
+    Opens the log file if no game has opened it yet.
+*/
+static FILE* openLog() {
+    if (!logFile) logFile = fopen("./output.txt", "a");
+    return logFile;
+}
+
+/*
+    Console echo. While it runs, log lines are copied into a bounded queue and a separate thread
+    writes them to stdout, so a slow terminal only ever holds up that thread. When the queue is full
+    the line is dropped from the console and counted, the log file still gets every line.
+*/
+#define ECHO_BATCH      64
+
+static LogLineType *echoQueue = NULL;
+static int echoCapacity = 0;
+static int echoHead = 0;
+static int echoCount = 0;
+static int echoBusy = C_FALSE;
+static int echoStopping = C_FALSE;
+static long echoDropped = 0;
+static long echoReported = 0;
+static pthread_t echoThread;
+static pthread_mutex_t echoLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t echoReady = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t echoDrained = PTHREAD_COND_INITIALIZER;
+
+/*
+    Writes queued lines to the console until the echo is stopped and the queue is empty.
+    in: arg - unused
+    return: NULL
+*/
+static void* echoLogic(void *arg) {
+    (void) arg;
+    LogLineType *batch = safeMalloc(sizeof(LogLineType) * ECHO_BATCH);
+
+    pthread_mutex_lock(&echoLock);
+    while (1) {
+        while (echoCount == 0 && echoDropped == echoReported && !echoStopping) pthread_cond_wait(&echoReady, &echoLock);
+        if (echoCount == 0 && echoDropped == echoReported) break;
+
+        // Take a batch and write it without the lock so producers never wait on the console
+        int count = echoCount < ECHO_BATCH ? echoCount : ECHO_BATCH;
+        for (int i = 0; i < count; i++) {
+            const LogLineType *line = &echoQueue[(echoHead + i) % echoCapacity];
+            memcpy(batch[i].buf, line->buf, line->len);
+            batch[i].len = line->len;
+        }
+        echoHead = (echoHead + count) % echoCapacity;
+        echoCount -= count;
+        long dropped = echoDropped - echoReported;
+        echoReported = echoDropped;
+        echoBusy = C_TRUE;
+        pthread_mutex_unlock(&echoLock);
+
+        for (int i = 0; i < count; i++) fwrite(batch[i].buf, 1, batch[i].len, stdout);
+        if (dropped > 0) printf("[ECHO] %ld lines were dropped from the console, output.txt has every line\n", dropped);
+        fflush(stdout);
+
+        pthread_mutex_lock(&echoLock);
+        echoBusy = C_FALSE;
+        if (echoCount == 0) pthread_cond_broadcast(&echoDrained);
+    }
+    pthread_cond_broadcast(&echoDrained);
+    pthread_mutex_unlock(&echoLock);
+
+    free(batch);
+    return NULL;
+}
+
+/*
+    Starts the console echo thread.
+    in: capacity - how many lines the queue holds, 0 keeps writing to the console directly
+*/
+void l_startEcho(int capacity) {
+    if (capacity <= 0 || echoQueue) return;
+    echoQueue = safeMalloc(sizeof(LogLineType) * capacity);
+    echoCapacity = capacity;
+    echoHead = 0;
+    echoCount = 0;
+    echoDropped = 0;
+    echoReported = 0;
+    echoStopping = C_FALSE;
+    pthread_create(&echoThread, NULL, echoLogic, NULL);
+}
+
+/*
+    Waits until every queued line is on the console, anything else printed afterwards comes after them.
+*/
+void l_flushEcho() {
+    if (!echoQueue) return;
+    pthread_mutex_lock(&echoLock);
+    while (echoCount > 0 || echoBusy || echoDropped != echoReported) pthread_cond_wait(&echoDrained, &echoLock);
+    pthread_mutex_unlock(&echoLock);
+}
+
+/*
+    Writes out the queued lines and stops the console echo thread.
+*/
+void l_stopEcho() {
+    if (!echoQueue) return;
+    pthread_mutex_lock(&echoLock);
+    echoStopping = C_TRUE;
+    pthread_cond_signal(&echoReady);
+    pthread_mutex_unlock(&echoLock);
+    pthread_join(echoThread, NULL);
+
+    free(echoQueue);
+    echoQueue = NULL;
+}
+
+/*
+    Hands a line to the echo thread, or drops it if the queue is full.
+    in: line - the line to echo
+*/
+static void echoLine(const LogLineType *line) {
+    pthread_mutex_lock(&echoLock);
+    if (echoCount == echoCapacity) {
+        echoDropped++;
+    } else {
+        LogLineType *slot = &echoQueue[(echoHead + echoCount) % echoCapacity];
+        memcpy(slot->buf, line->buf, line->len);
+        slot->len = line->len;
+        echoCount++;
+        pthread_cond_signal(&echoReady);
+    }
+    pthread_mutex_unlock(&echoLock);
+}
+
+/*
+    Writes a finished log line to the console and the log file.
+    in: line - the line to write
+*/
+static void lineWrite(const LogLineType *line) {
+    PROFILE_BEGIN(PROF_LOG);
+    if (echoQueue) {
+        echoLine(line);
+    } else {
+        fwrite(line->buf, 1, line->len, stdout);
+    }
+    FILE *file = openLog();
+    if (file) {
+        fwrite(line->buf, 1, line->len, file);
+        fflush(file);
+    }
+    PROFILE_END();
+}
+
+/*
+    Turns all of the logging functions on or off.
+    in: enabled - C_TRUE to log, C_FALSE to skip logging
+*/
+void l_setLogging(int enabled) {
+    logEnabled = enabled;
+}
+
+/*
+    Starts a new log for a game by truncating the log file.
+*/
+void l_gameStart() {
+    if (!logEnabled) return;
+    if (logFile) fclose(logFile);
+    logFile = fopen("./output.txt", "w");
+}
+
 /* 
     Logs the hunter being created.
     in: hunter - the hunter name to log
     in: equipment - the hunter's equipment
 */
 void l_hunterInit(char* hunter, enum EvidenceType equipment) {
-    if (!LOGGING) return;
-    char evStr[MAX_STR];
-    evidenceToString(equipment, evStr);
-    FILE *logFile = fopen("./output.txt", "a");
-    const char logString[] = "%-17s [%s] is a [%s] hunter\n";
-    printf(logString, "[HUNTER INIT]", hunter, evStr);
-    fprintf(logFile, logString, "[HUNTER INIT]", hunter, evStr);
-    fclose(logFile);
+    if (!logEnabled) return;
+    LogLineType line = { .len = 0 };
+    lineFragment(&line, &TAG_HUNTER_INIT);
+    lineName(&line, hunter);
+    lineAppend(&line, " is a [", 7);
+    lineFragment(&line, &evidenceNames[equipment]);
+    lineAppend(&line, "] hunter\n", 9);
+    lineWrite(&line);
 }
 
 /*
@@ -22,12 +286,14 @@ void l_hunterInit(char* hunter, enum EvidenceType equipment) {
     in: room - the room name to log
 */
 void l_hunterMove(char* hunter, char* room) {
-    if (!LOGGING) return;
-    FILE *logFile = fopen("./output.txt", "a");
-    const char logString[] = "%-17s [%s] has moved into [%s]\n";
-    printf(logString, "[HUNTER MOVE]", hunter, room);
-    fprintf(logFile, logString, "[HUNTER MOVE]", hunter, room);
-    fclose(logFile);
+    if (!logEnabled) return;
+    LogLineType line = { .len = 0 };
+    lineFragment(&line, &TAG_HUNTER_MOVE);
+    lineName(&line, hunter);
+    lineAppend(&line, " has moved into ", 16);
+    lineName(&line, room);
+    lineAppend(&line, "\n", 1);
+    lineWrite(&line);
 }
 
 /*
@@ -36,30 +302,13 @@ void l_hunterMove(char* hunter, char* room) {
     in: reason - the reason for exiting, either LOG_FEAR, LOG_BORED, or LOG_EVIDENCE
 */
 void l_hunterExit(char* hunter, enum LoggerDetails reason) {
-    if (!LOGGING) return;
-    FILE *logFile = fopen("./output.txt", "a");
-    const char logString[] = "%-17s [%s] exited because ";
-    printf(logString, "[HUNTER EXIT]", hunter);
-    fprintf(logFile, logString, "[HUNTER EXIT]", hunter);
-
-    switch (reason) {
-        case LOG_FEAR:
-            printf("[FEAR]\n");
-            fprintf(logFile, "[FEAR]\n");
-            break;
-        case LOG_BORED:
-            printf("[BORED]\n");
-            fprintf(logFile, "[BORED]\n");
-            break;
-        case LOG_EVIDENCE:
-            printf("[EVIDENCE]\n");
-            fprintf(logFile, "[EVIDENCE]\n");
-            break;
-        default:
-            printf("[UNKNOWN]\n");
-            fprintf(logFile, "[UNKNOWN]\n");
-    }
-    fclose(logFile);
+    if (!logEnabled) return;
+    LogLineType line = { .len = 0 };
+    lineFragment(&line, &TAG_HUNTER_EXIT);
+    lineName(&line, hunter);
+    lineAppend(&line, " exited because ", 16);
+    lineReason(&line, reason, (1 << LOG_FEAR) | (1 << LOG_BORED) | (1 << LOG_EVIDENCE));
+    lineWrite(&line);
 }
 
 /*
@@ -68,25 +317,13 @@ void l_hunterExit(char* hunter, enum LoggerDetails reason) {
     in: result - the result of the review, either LOG_SUFFICIENT or LOG_INSUFFICIENT
 */
 void l_hunterReview(char* hunter, enum LoggerDetails result) {
-    if (!LOGGING) return;
-    FILE *logFile = fopen("./output.txt", "a");
-    const char logString[] = "%-17s [%s] reviewed evidence and found ";
-    printf(logString, "[HUNTER REVIEW]", hunter);
-    fprintf(logFile, logString, "[HUNTER REVIEW]", hunter);
-    switch (result) {
-        case LOG_SUFFICIENT:
-            printf("[SUFFICIENT]\n");
-            fprintf(logFile, "[SUFFICIENT]\n");
-            break;
-        case LOG_INSUFFICIENT:
-            printf("[INSUFFICIENT]\n");
-            fprintf(logFile, "[INSUFFICIENT]\n");
-            break;
-        default:
-            printf("[UNKNOWN]\n");
-            fprintf(logFile, "[UNKNOWN]\n");
-    }
-    fclose(logFile);
+    if (!logEnabled) return;
+    LogLineType line = { .len = 0 };
+    lineFragment(&line, &TAG_HUNTER_REVIEW);
+    lineName(&line, hunter);
+    lineAppend(&line, " reviewed evidence and found ", 29);
+    lineReason(&line, result, (1 << LOG_SUFFICIENT) | (1 << LOG_INSUFFICIENT));
+    lineWrite(&line);
 }
 
 /*
@@ -96,14 +333,38 @@ void l_hunterReview(char* hunter, enum LoggerDetails result) {
     in: room - the room name to log
 */
 void l_hunterCollect(char* hunter, enum EvidenceType evidence, char* room) {
-    if (!LOGGING) return;
-    char evStr[MAX_STR];
-    evidenceToString(evidence, evStr);
-    FILE *logFile = fopen("./output.txt", "a");
-    const char logString[] = "%-17s [%s] found [%s] in [%s] and [COLLECTED]\n";
-    printf(logString, "[HUNTER EVIDENCE]", hunter, evStr, room);
-    fprintf(logFile, logString, "[HUNTER EVIDENCE]", hunter, evStr, room);
-    fclose(logFile);
+    if (!logEnabled) return;
+    LogLineType line = { .len = 0 };
+    lineFragment(&line, &TAG_HUNTER_EVIDENCE);
+    lineName(&line, hunter);
+    lineAppend(&line, " found [", 8);
+    lineFragment(&line, &evidenceNames[evidence]);
+    lineAppend(&line, "] in ", 5);
+    lineName(&line, room);
+    lineAppend(&line, " and [COLLECTED]\n", 17);
+    lineWrite(&line);
+}
+
+/*
+    Logs the hunter collecting several pieces of evidence at once.
+    in: hunter - the hunter name to log
+    in: evidence - the evidence type to log
+    in: count - how many pieces were collected
+    in: room - the room name to log
+*/
+void l_hunterCollectBatch(char* hunter, enum EvidenceType evidence, int count, char* room) {
+    if (!logEnabled) return;
+    LogLineType line = { .len = 0 };
+    lineFragment(&line, &TAG_HUNTER_EVIDENCE);
+    lineName(&line, hunter);
+    lineAppend(&line, " found [", 8);
+    lineFragment(&line, &evidenceNames[evidence]);
+    lineAppend(&line, "] x", 3);
+    lineInt(&line, count);
+    lineAppend(&line, " in ", 4);
+    lineName(&line, room);
+    lineAppend(&line, " and [COLLECTED]\n", 17);
+    lineWrite(&line);
 }
 
 /*
@@ -111,42 +372,26 @@ void l_hunterCollect(char* hunter, enum EvidenceType evidence, char* room) {
     in: room - the room name to log
 */
 void l_ghostMove(char* room) {
-    if (!LOGGING) return;
-    FILE *logFile = fopen("./output.txt", "a");
-    const char logString[] = "%-17s Ghost has moved into [%s]\n";
-    printf(logString, "[GHOST MOVE]", room);
-    fprintf(logFile, logString, "[GHOST MOVE]", room);
-    fclose(logFile); 
+    if (!logEnabled) return;
+    LogLineType line = { .len = 0 };
+    lineFragment(&line, &TAG_GHOST_MOVE);
+    lineAppend(&line, "Ghost has moved into ", 21);
+    lineName(&line, room);
+    lineAppend(&line, "\n", 1);
+    lineWrite(&line);
 }
 
 /*
     Logs the ghost exiting the house.
-    in: reason - the reason for exiting, either LOG_FEAR, LOG_BORED, or LOG_EVIDENCE
+    in: reason - the reason for exiting, either LOG_BORED, LOG_EVIDENCE, or LOG_ALONE
 */
 void l_ghostExit(enum LoggerDetails reason) {
-    if (!LOGGING) return;
-    FILE *logFile = fopen("./output.txt", "a");
-    const char logString[] = "%-17s Exited because ";
-    printf(logString, "[GHOST EXIT]");
-    fprintf(logFile, logString, "[GHOST EXIT]");
-    switch (reason) {
-        case LOG_FEAR:
-            printf("[FEAR]\n");
-            fprintf(logFile, "[FEAR]\n");
-            break;
-        case LOG_BORED:
-            printf("[BORED]\n");
-            fprintf(logFile, "[BORED]\n");
-            break;
-        case LOG_EVIDENCE:
-            printf("[EVIDENCE]\n");
-            fprintf(logFile, "[EVIDENCE]\n");
-            break;
-        default:
-            printf("[UNKNOWN]\n");
-            fprintf(logFile, "[UNKNOWN]\n");
-    }
-    fclose(logFile);
+    if (!logEnabled) return;
+    LogLineType line = { .len = 0 };
+    lineFragment(&line, &TAG_GHOST_EXIT);
+    lineAppend(&line, "Exited because ", 15);
+    lineReason(&line, reason, (1 << LOG_FEAR) | (1 << LOG_BORED) | (1 << LOG_EVIDENCE) | (1 << LOG_ALONE));
+    lineWrite(&line);
 }
 
 /*
@@ -155,14 +400,42 @@ void l_ghostExit(enum LoggerDetails reason) {
     in: room - the room name to log
 */
 void l_ghostEvidence(enum EvidenceType evidence, char* room) {
-    if (!LOGGING) return;
-    char evStr[MAX_STR];
-    evidenceToString(evidence, evStr);
-    FILE *logFile = fopen("./output.txt", "a");
-    const char logString[] = "%-17s Ghost left [%s] in [%s]\n";
-    printf(logString, "[GHOST EVIDENCE]", evStr, room);
-    fprintf(logFile, logString, "[GHOST EVIDENCE]", evStr, room );
-    fclose(logFile);    
+    if (!logEnabled) return;
+    LogLineType line = { .len = 0 };
+    lineFragment(&line, &TAG_GHOST_EVIDENCE);
+    lineAppend(&line, "Ghost left [", 12);
+    lineFragment(&line, &evidenceNames[evidence]);
+    lineAppend(&line, "] in ", 5);
+    lineName(&line, room);
+    lineAppend(&line, "\n", 1);
+    lineWrite(&line);
+}
+
+/*
+    Logs the ghost leaving several pieces of evidence in a room at once.
+    in: counts - how many pieces of each evidence type were left
+    in: room - the room name to log
+*/
+void l_ghostEvidenceBatch(int counts[], char* room) {
+    if (!logEnabled) return;
+    LogLineType line = { .len = 0 };
+    int first = C_TRUE;
+    lineFragment(&line, &TAG_GHOST_EVIDENCE);
+    lineAppend(&line, "Ghost left ", 11);
+    for(int ev = 0; ev < EV_COUNT; ev++) {
+        if(counts[ev] == 0) continue;
+        if(!first) lineAppend(&line, " ", 1);
+        lineAppend(&line, "[", 1);
+        lineFragment(&line, &evidenceNames[ev]);
+        lineAppend(&line, " x", 2);
+        lineInt(&line, counts[ev]);
+        lineAppend(&line, "]", 1);
+        first = C_FALSE;
+    }
+    lineAppend(&line, " in ", 4);
+    lineName(&line, room);
+    lineAppend(&line, "\n", 1);
+    lineWrite(&line);
 }
 
 /*
@@ -171,25 +444,28 @@ void l_ghostEvidence(enum EvidenceType evidence, char* room) {
     in: room - the room name that the ghost is starting in
 */
 void l_ghostInit(enum GhostClass ghost, char* room) {
-    if (!LOGGING) return;
-    char ghostStr[MAX_STR];
-    ghostToString(ghost, ghostStr);
-    FILE *logFile = fopen("./output.txt", "w");
-    const char logString[] = "%-17s Ghost is a [%s] in room [%s]\n";
-    printf(logString, "[GHOST INIT]", ghostStr, room);
-    fprintf(logFile, logString, "[GHOST INIT]", ghostStr, room);
-    fclose(logFile);
+    if (!logEnabled) return;
+    LogLineType line = { .len = 0 };
+    lineFragment(&line, &TAG_GHOST_INIT);
+    lineAppend(&line, "Ghost is a ", 11);
+    lineName(&line, ghostName(ghost));
+    lineAppend(&line, " in room ", 9);
+    lineName(&line, room);
+    lineAppend(&line, "\n", 1);
+    lineWrite(&line);
 }
 
 /*
     Logs the final status of the game and who won
-    in: ghost - the ghost that was in the game
+    in: ghosts - the ghosts that were in the game
     in: hunters - the hunters that played the game 
     in: hunterEvList - the evidence collected by the hunters during the game
+    in: huntersWon - whether the hunters deduced every ghost correctly, from isGameWon()
 */
-void l_gameComplete(GhostType *ghost, HunterListType *hunters, EvidenceListType *hunterEvList) {
-    if(!LOGGING) return;
-    FILE *logFile = fopen("./output.txt", "a");
+void l_gameComplete(GhostListType *ghosts, HunterListType *hunters, EvidenceListType *hunterEvList, int huntersWon) {
+    if (!logEnabled || !openLog()) return;
+    // The results are printed directly so every event has to be on the console first
+    l_flushEcho();
     const char lineSeperate[] = "--------------------------------\n";
     // Header
     printf(lineSeperate);
@@ -205,25 +481,25 @@ void l_gameComplete(GhostType *ghost, HunterListType *hunters, EvidenceListType
     // Find out how many hunters were to scared or bored to continue hunting
     for(int i = 0; i < hunters->size; i++) {
         HunterType *hunter = hunters->hunters[i];
-        if(hunter->boredom >= BOREDOM_MAX) addHunter(boredHunters, hunter);
-        if(hunter->fear >= FEAR_MAX) addHunter(scaredHunters, hunter);
+        if(hunter->boredom >= hunter->boredomMax) addHunter(boredHunters, hunter);
+        if(hunter->fear >= hunter->fearMax) addHunter(scaredHunters, hunter);
     }
     
-    // Setup some booleans that might change how we print
-    int ghostGotBored = ghost->boredomTimer >= BOREDOM_MAX;
-    int allHuntersLeft = boredHunters->size + scaredHunters->size == 4;
-
-    if(!allHuntersLeft) {
-        char ghostStr[MAX_STR];
-        ghostToString(ghost->class, ghostStr);
-
-        if(ghostGotBored) {
+    for(int i = 0; i < ghosts->size; i++) {
+        GhostType *ghost = ghosts->ghosts[i];
+        if(ghost->boredomTimer >= ghost->config->boredomMax) {
             printf("%-40s\n", "The ghost was no longer interested in haunting this house!");
             fprintf(logFile, "%-40s\n", "The ghost was no longer interested in haunting this house!");
         }
+    }
 
-        printf("The ghost was discovered to be a %-30s.\n", ghostStr);
-        fprintf(logFile, "The ghost was discovered to be a %-30s.\n", ghostStr);
+    if(huntersWon) {
+        // A win means every deduction was right, so this is what the hunters worked out
+        for(int i = 0; i < ghosts->size; i++) {
+            const char *ghostStr = ghostName(ghosts->ghosts[i]->deduced);
+            printf("The ghost was discovered to be a %-30s.\n", ghostStr);
+            fprintf(logFile, "The ghost was discovered to be a %-30s.\n", ghostStr);
+        }
 
         printf("%-40s\n", "The hunters were able to determine the type of ghost!");
         fprintf(logFile, "%-40s\n", "The hunters were able to determine the type of ghost!");
@@ -231,6 +507,14 @@ void l_gameComplete(GhostType *ghost, HunterListType *hunters, EvidenceListType
         printf("%-40s\n\n", "The hunters have won the game.");
         fprintf(logFile, "%-40s\n\n", "The hunters have won the game.");
     } else {
+        // Hunters that settled on the wrong class still lose
+        for(int i = 0; i < ghosts->size; i++) {
+            GhostType *ghost = ghosts->ghosts[i];
+            if(ghost->identified && ghost->deduced != ghost->class) {
+                printf("The hunters mistook the ghost for a %-30s.\n", ghostName(ghost->deduced));
+                fprintf(logFile, "The hunters mistook the ghost for a %-30s.\n", ghostName(ghost->deduced));
+            }
+        }
         printf("%-40s\n\n", "The ghost won and will continue to haunt the house.");
         fprintf(logFile, "%-40s\n\n", "The ghost won and will continue to haunt the house.");
     }
@@ -241,11 +525,13 @@ void l_gameComplete(GhostType *ghost, HunterListType *hunters, EvidenceListType
 
     printf("\n");
 
-    printf("%-40s\n", "The evidence needed for the ghost is:");
-    fprintf(logFile, "%-40s\n", "The evidence needed for the ghost is:");
-    printEvidence(logFile, ghost->evList);
+    for(int i = 0; i < ghosts->size; i++) {
+        printf("%-40s\n", "The evidence needed for the ghost is:");
+        fprintf(logFile, "%-40s\n", "The evidence needed for the ghost is:");
+        printEvidence(logFile, ghosts->ghosts[i]->evList);
 
-    printf("\n");
+        printf("\n");
+    }
     
     int huntersGotBored = boredHunters->size > 0;
     int huntersGotScared = scaredHunters->size > 0;
@@ -275,8 +561,11 @@ void l_gameComplete(GhostType *ghost, HunterListType *hunters, EvidenceListType
         printf("\n");
     }
 
-    // Cleanup all of the memory we used 
+    // Cleanup all of the memory we used, the next game starts a new log
     fclose(logFile);
+    logFile = NULL;
+    free(boredHunters->hunters);
     free(boredHunters);
+    free(scaredHunters->hunters);
     free(scaredHunters);
 }
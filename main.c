@@ -1,115 +1,90 @@
 #include "defs.h"
 
 int main(int argc, char *argv[]) {
-    int isBonus = argc == 2 && strcmp(argv[1], "bonus") == 0;
+    ConfigType config;
+    initConfig(&config);
 
-    // Initialize the random number generator
-    srand(time(NULL));
+    // Read the simulation parameters from the command line and any config file it names
+    if(!parseArgs(&config, argc, argv)) {
+        printf("Usage: %s [bonus] [random|explore|evidence] [--config=FILE] [--KEY=VALUE]... [--sweep=KEY:FROM:TO[:STEP]]... [--stats=1] [--csv=FILE] [--snapshot=FILE --snapshot-at=N] [--restore=FILE] [--roster=FILE|-] [--jobs=N] [--cpus=LIST] [--replay=FILE] [--fuzz=N]\n", argv[0]);
+        return 1;
+    }
 
-    HouseType *house;
-    GhostType *ghost;
+    // Batches of games can not stop to ask for the hunters every time
+    if(config.games > 1 || config.sweepCount > 0) config.prompt = C_FALSE;
+    // Games played in parallel would all write the one log
+    if(config.jobs > 1) config.logging = C_FALSE;
+    l_setLogging(config.logging);
 
-    // Initialize the house and populate it with rooms
-    initHouse(&house);
-    populateRooms(house);
+    // The roster is read once and shared by every game
+    RosterType *roster = NULL;
+    if(config.rosterPath[0] != '\0') {
+        if(!loadRoster(config.rosterPath, &roster)) return 1;
+        config.roster = roster;
+        config.numHunters = roster->size;
+    }
 
-    // Initialize the ghost and add it to the house 
-    initGhost(house, &ghost);
+    // A replay only reads a log, it never plays a game
+    if(config.replayPath[0] != '\0') {
+        int passed = runReplay(&config);
+        cleanupRoster(roster);
+        return passed ? 0 : 1;
+    }
 
-    HunterListType *hunterList = createHunterList();
+    // Initialize the random number generator
+    srand(time(NULL));
 
-    // Initialize the hunters
-    char hunterName[MAX_STR];
-    int ev;
-    // Used to give each hunter a unique id
-    int id = NUM_HUNTERS;
-    // Used as an array to hold the current taken enum values for evidence
-    unsigned char takenEvidence = 0;
-    EvidenceListType *evList;
-    
-    // Asking for a user specified evidence changes the program so it is bonus only
-    if(!isBonus) {
-        evList = createEvidenceList();
-        addEvidence(evList, FINGERPRINTS);
-        addEvidence(evList, EMF);
-        addEvidence(evList, SOUND);
-        addEvidence(evList, TEMPERATURE);
+    if(config.fuzz > 0) {
+        int passed = runFuzz(&config);
+        cleanupRoster(roster);
+        return passed ? 0 : 1;
     }
-    
-    // Loop to get information about the hunters 
-    while(id > 0) {
-        HunterType *currentHunter;
-        // Collect their name
-        printf("Please enter the hunters name: ");
-        scanf("%s", hunterName);
-        
-        if(isBonus) {
-            // Evidence has strict restrictions so loop until they are met 
-            while(1) {
-                printf("Please enter their evidence type (0 - EMF, 1 - TEMPERATURE, 2 - FINGERPRINTS, 3 - SOUND): ");
-                scanf("%d", &ev);
-                // Check if it is a valid choice 
-                if(!(ev >= 0) || !(ev <= 3)) {
-                    printf("That is not a valid evidence type!\n");
-                    continue;
-                }
 
-                // Check if the bit at the enum int value is set 
-                if((takenEvidence >> ev) & 1) {
-                    printf("Please enter an evidence type that has not been taken!\n");
-                } else { 
-                    // Set the bit at the given enum value
-                    takenEvidence = takenEvidence | (1 << ev);
-                    break;
-                }
-            }
-        } else {
-            // Pick a random evidence from the remaining choices
-            ev = randomEvidence(evList);
-            // Remove it after since we can't have the same type twice 
-            removeEvidence(evList, ev);
-        }
-    
-        // Init the hunter and add it to our list
-        initHunter(&currentHunter, ghost, house, hunterName, &id, (EvidenceType) ev);
-        addHunter(hunterList, currentHunter);
+    if(config.stress > 0) {
+        int passed = runStress(&config);
+        cleanupHouseCache();
+        cleanupRoster(roster);
+        return passed ? 0 : 1;
     }
-    
-    // If we create an evidence list then free it
-    if(!isBonus) free(evList);
-    
-    // Reuse the hunter list for house
-    house->hunterList = hunterList;
-    
-    // Start the threads
-    pthread_t* ghostThread = startGhostThread(ghost);
-    pthread_t* hunter1Thread = startHunterThread(hunterList->hunters[0]);
-    pthread_t* hunter2Thread = startHunterThread(hunterList->hunters[1]);
-    pthread_t* hunter3Thread = startHunterThread(hunterList->hunters[2]);
-    pthread_t* hunter4Thread = startHunterThread(hunterList->hunters[3]);
 
-    // Wait for the threads to finish
-    pthread_join(*ghostThread, NULL);
-    pthread_join(*hunter1Thread, NULL);
-    pthread_join(*hunter2Thread, NULL);
-    pthread_join(*hunter3Thread, NULL);
-    pthread_join(*hunter4Thread, NULL);
-
-    // Cleanup the threads
-    free(ghostThread);
-    free(hunter1Thread);
-    free(hunter2Thread);
-    free(hunter3Thread);
-    free(hunter4Thread);
-
-    l_gameComplete(ghost, house->hunterList, house->evidence);
+    // Per game rows are streamed to the CSV file so batches never hold every game in memory
+    FILE *csv = NULL;
+    if(config.csvPath[0] != '\0') {
+        csv = fopen(config.csvPath, "w");
+        if(!csv) {
+            printf("Could not open %s\n", config.csvPath);
+            cleanupRoster(roster);
+            return 1;
+        }
+        writeCsvHeader(csv);
+    }
 
-    // Cleanup the ghost
-    cleanupGhost(ghost);
+    // Log lines reach the console through the echo thread so a slow terminal never holds up a game
+    if(config.logging) l_startEcho(config.echoQueue);
+    startMetrics(&config);
+    int status = 0;
+    if(config.sweepCount > 0) {
+        if(!runSweep(&config, csv)) status = 1;
+    } else {
+        StatsType stats;
+        initStats(&stats, csv);
+        if(config.jobs > 1 || config.cpuList[0] != '\0') {
+            runJobs(&config, &stats);
+        } else {
+            for(int game = 0; game < config.games; game++) {
+                runGame(&config, &stats);
+            }
+        }
+        if(config.stats) printStats(stdout, &stats);
+        cleanupStats(&stats);
+    }
 
-    // Cleanup the house
-    cleanupHouse(house);
+    l_stopEcho();
+    stopMetrics();
+    if(csv) fclose(csv);
+    PROFILE_REPORT(stdout);
+    cleanupHouseCache();
+    cleanupRoster(roster);
 
-    return 0; 
+    return status; 
 }
-
@@ -0,0 +1,270 @@
+#include "defs.h"
+
+/*
+    Live metrics for long batches. Games are counted with relaxed atomics once per game. Lock waits are
+    only timed while metrics are on and only on the contended lock path, each thread adds them to its own
+    counters that the writer thread sums, so the lock path never touches a cache line another thread writes.
+    With --metrics=FILE a thread rewrites FILE in the Prometheus text format every --metrics-every
+    milliseconds, writing a temporary file first and renaming it so readers never see half a file.
+*/
+
+// Process wide counters, only accessed atomically
+static long metricGames = 0;
+static long metricWins = 0;
+static long metricGamesByClass[GHOST_COUNT];
+static long metricWinsByClass[GHOST_COUNT];
+static long metricTicks = 0;
+
+// Lock waits of one thread, only that thread writes them and the writer thread reads them
+typedef struct MetricsThread {
+    long waits;
+    long long waitNs;
+    struct MetricsThread *prev;
+    struct MetricsThread *next;
+} MetricsThreadType;
+
+// Threads that have waited on a lock and the totals of those that have exited, under threadsLock
+static MetricsThreadType *liveThreads = NULL;
+static long exitedLockWaits = 0;
+static long long exitedLockWaitNs = 0;
+static pthread_mutex_t threadsLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t threadKey;
+static pthread_once_t threadKeyOnce = PTHREAD_ONCE_INIT;
+static __thread MetricsThreadType *threadWaits = NULL;
+static int metricsOn = C_FALSE;
+
+// The writer thread, only started when a metrics file was given
+static const char *metricsPath = NULL;
+static int metricsEvery = 0;
+static struct timespec metricsStart;
+static pthread_t metricsThread;
+static pthread_mutex_t metricsLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t metricsCond = PTHREAD_COND_INITIALIZER;
+static int metricsStopping = C_FALSE;
+
+/*  Function: metricsGame()
+    Description: Counts a finished game
+
+    in: HouseType *house - The house the game was played in
+    in: int huntersWon - C_TRUE if the hunters won
+    in: int ticks - How long the game lasted
+
+    Returns: None
+*/
+void metricsGame(HouseType *house, int huntersWon, int ticks) {
+    if (!house) return; // Check for NULL pointer
+    __atomic_add_fetch(&metricGames, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&metricTicks, ticks, __ATOMIC_RELAXED);
+    if(huntersWon) __atomic_add_fetch(&metricWins, 1, __ATOMIC_RELAXED);
+
+    for(int i = 0; i < house->ghostList->size; i++) {
+        GhostClass ghostClass = house->ghostList->ghosts[i]->class;
+        __atomic_add_fetch(&metricGamesByClass[ghostClass], 1, __ATOMIC_RELAXED);
+        if(huntersWon) __atomic_add_fetch(&metricWinsByClass[ghostClass], 1, __ATOMIC_RELAXED);
+    }
+}
+
+/*  Function: metricsThreadExit()
+    Description: Adds an exiting thread's lock waits to the totals and forgets the thread, called by pthreads
+
+    in: void *ptr - Pointer to the thread's MetricsThreadType
+
+    Returns: None
+*/
+static void metricsThreadExit(void *ptr) {
+    MetricsThreadType *counters = (MetricsThreadType*) ptr;
+    pthread_mutex_lock(&threadsLock);
+    exitedLockWaits += counters->waits;
+    exitedLockWaitNs += counters->waitNs;
+    if(counters->prev) counters->prev->next = counters->next;
+    else liveThreads = counters->next;
+    if(counters->next) counters->next->prev = counters->prev;
+    pthread_mutex_unlock(&threadsLock);
+    free(counters);
+}
+
+/*  Function: createThreadKey()
+    Description: Creates the key whose destructor folds a thread's counters in when it exits
+
+    in: None
+
+    Returns: None
+*/
+static void createThreadKey() {
+    pthread_key_create(&threadKey, metricsThreadExit);
+}
+
+/*  Function: metricsLockWait()
+    Description: Counts a wait on a lock that was already taken in the calling thread's counters,
+                 the thread's first wait registers them with the writer
+
+    in: long long ns - How long the wait took in nanoseconds
+
+    Returns: None
+*/
+void metricsLockWait(long long ns) {
+    if(!threadWaits) {
+        pthread_once(&threadKeyOnce, createThreadKey);
+        threadWaits = safeMalloc(sizeof(MetricsThreadType));
+        threadWaits->waits = 0;
+        threadWaits->waitNs = 0;
+        threadWaits->prev = NULL;
+        pthread_mutex_lock(&threadsLock);
+        threadWaits->next = liveThreads;
+        if(liveThreads) liveThreads->prev = threadWaits;
+        liveThreads = threadWaits;
+        pthread_mutex_unlock(&threadsLock);
+        pthread_setspecific(threadKey, threadWaits);
+    }
+    // Only this thread writes, the stores are atomic so the writer never reads a torn value
+    __atomic_store_n(&threadWaits->waits, threadWaits->waits + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&threadWaits->waitNs, threadWaits->waitNs + ns, __ATOMIC_RELAXED);
+}
+
+/*  Function: metricsEnabled()
+    Description: Checks whether lock waits should be timed, set before any game thread starts
+
+    in: None
+
+    Returns: int - C_TRUE if a metrics file is being written, C_FALSE otherwise
+*/
+int metricsEnabled() {
+    return metricsOn;
+}
+
+/*  Function: writeMetric()
+    Description: Writes the help and type lines of a metric followed by its value
+
+    in/out: FILE *file - The file to write to
+    in: const char *name - The metric name
+    in: const char *type - "counter" or "gauge"
+    in: const char *help - What the metric measures
+    in: double value - The current value
+
+    Returns: None
+*/
+static void writeMetric(FILE *file, const char *name, const char *type, const char *help, double value) {
+    fprintf(file, "# HELP %s %s\n# TYPE %s %s\n%s %.9g\n", name, help, name, type, name, value);
+}
+
+/*  Function: writeMetrics()
+    Description: Rewrites the metrics file with the current counters
+
+    in: None
+
+    Returns: None
+*/
+static void writeMetrics() {
+    char tmpPath[MAX_PATH + 8];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", metricsPath);
+    FILE *file = fopen(tmpPath, "w");
+    if (!file) return; // Try again next time
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double uptime = (now.tv_sec - metricsStart.tv_sec) + (now.tv_nsec - metricsStart.tv_nsec) / 1e9;
+    long games = __atomic_load_n(&metricGames, __ATOMIC_RELAXED);
+    long ticks = __atomic_load_n(&metricTicks, __ATOMIC_RELAXED);
+
+    // Lock waits are the exited threads' totals plus whatever the live threads have counted so far
+    pthread_mutex_lock(&threadsLock);
+    long lockWaits = exitedLockWaits;
+    long long lockWaitNs = exitedLockWaitNs;
+    for(MetricsThreadType *counters = liveThreads; counters; counters = counters->next) {
+        lockWaits += __atomic_load_n(&counters->waits, __ATOMIC_RELAXED);
+        lockWaitNs += __atomic_load_n(&counters->waitNs, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&threadsLock);
+
+    writeMetric(file, "a5_uptime_seconds", "gauge", "Seconds since the batch started.", uptime);
+    writeMetric(file, "a5_games_total", "counter", "Games completed.", games);
+    writeMetric(file, "a5_games_per_second", "gauge", "Games completed per second since the batch started.",
+        uptime > 0 ? games / uptime : 0);
+    writeMetric(file, "a5_hunter_wins_total", "counter", "Games the hunters won.", __atomic_load_n(&metricWins, __ATOMIC_RELAXED));
+    writeMetric(file, "a5_ticks_mean", "gauge", "Mean ticks per game.", games > 0 ? (double) ticks / games : 0);
+    writeMetric(file, "a5_lock_waits_total", "counter", "Waits on a room or evidence lock that was already taken.",
+        lockWaits);
+    writeMetric(file, "a5_lock_wait_seconds_total", "counter", "Time spent waiting on locks that were already taken.",
+        lockWaitNs / 1e9);
+
+    // One series per ghost class
+    fprintf(file, "# HELP a5_class_games_total Ghosts of each class played against.\n# TYPE a5_class_games_total counter\n");
+    for(int c = 0; c < GHOST_COUNT; c++) {
+        fprintf(file, "a5_class_games_total{class=\"%s\"} %ld\n", ghostName(c), __atomic_load_n(&metricGamesByClass[c], __ATOMIC_RELAXED));
+    }
+    fprintf(file, "# HELP a5_class_win_ratio Share of games against each class the hunters won.\n# TYPE a5_class_win_ratio gauge\n");
+    for(int c = 0; c < GHOST_COUNT; c++) {
+        long played = __atomic_load_n(&metricGamesByClass[c], __ATOMIC_RELAXED);
+        long won = __atomic_load_n(&metricWinsByClass[c], __ATOMIC_RELAXED);
+        fprintf(file, "a5_class_win_ratio{class=\"%s\"} %.9g\n", ghostName(c), played > 0 ? (double) won / played : 0);
+    }
+
+    fclose(file);
+    rename(tmpPath, metricsPath);
+}
+
+/*  Function: metricsLogic()
+    Description: The main logic for the metrics thread, rewrites the file until it is stopped
+
+    in: void *arg - Unused
+
+    Returns: void* - NULL
+*/
+static void *metricsLogic(void *arg) {
+    (void) arg;
+    pthread_mutex_lock(&metricsLock);
+    while(!metricsStopping) {
+        struct timespec wake;
+        clock_gettime(CLOCK_REALTIME, &wake);
+        wake.tv_sec += metricsEvery / 1000;
+        wake.tv_nsec += (metricsEvery % 1000) * 1000000L;
+        if(wake.tv_nsec >= 1000000000L) {
+            wake.tv_sec++;
+            wake.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&metricsCond, &metricsLock, &wake);
+
+        pthread_mutex_unlock(&metricsLock);
+        writeMetrics();
+        pthread_mutex_lock(&metricsLock);
+    }
+    pthread_mutex_unlock(&metricsLock);
+    return NULL;
+}
+
+/*  Function: startMetrics()
+    Description: Starts rewriting config->metricsPath every config->metricsEvery milliseconds, does nothing
+                 when no metrics file was given
+
+    in: const ConfigType *config - The parameters of the batch
+
+    Returns: None
+*/
+void startMetrics(const ConfigType *config) {
+    if (config->metricsPath[0] == '\0') return; // Metrics are off
+    metricsPath = config->metricsPath;
+    metricsEvery = config->metricsEvery;
+    metricsStopping = C_FALSE;
+    metricsOn = C_TRUE;
+    clock_gettime(CLOCK_MONOTONIC, &metricsStart);
+    writeMetrics();
+    pthread_create(&metricsThread, NULL, metricsLogic, NULL);
+}
+
+/*  Function: stopMetrics()
+    Description: Stops the metrics thread, the file is written one last time with the final counters
+
+    in: None
+
+    Returns: None
+*/
+void stopMetrics() {
+    if (!metricsPath) return; // Metrics are off
+    pthread_mutex_lock(&metricsLock);
+    metricsStopping = C_TRUE;
+    pthread_cond_signal(&metricsCond);
+    pthread_mutex_unlock(&metricsLock);
+    pthread_join(metricsThread, NULL);
+    metricsPath = NULL;
+    metricsOn = C_FALSE;
+}
@@ -0,0 +1,103 @@
+#include "defs.h"
+
+#define PATH_NONE 0xFFFF
+
+/*  Function: buildPathTable()
+    Description: Runs a BFS from every room and stores the all-pairs distance and
+                 next-hop matrices for the house. The house must already be indexed.
+
+    in: HouseType *house - Pointer to the indexed house to build the table for
+
+    Returns: PathTableType* - Pointer to the newly created PathTableType struct
+*/
+PathTableType* buildPathTable(HouseType *house) {
+    if (!house || !house->roomIndex) return NULL; // Check for NULL pointers
+    int size = house->roomCount;
+
+    PathTableType *table = safeMalloc(sizeof(PathTableType));
+    table->size = size;
+    table->dist = safeMalloc(sizeof(unsigned short) * size * size);
+    table->nextHop = safeMalloc(sizeof(unsigned short) * size * size);
+    // Every byte set to 0xFF marks the pair as unreachable
+    memset(table->dist, 0xFF, sizeof(unsigned short) * size * size);
+    memset(table->nextHop, 0xFF, sizeof(unsigned short) * size * size);
+
+    int *queue = safeMalloc(sizeof(int) * size);
+
+    for(int from = 0; from < size; from++) {
+        unsigned short *dist = &table->dist[from * size];
+        unsigned short *hop = &table->nextHop[from * size];
+        int head = 0;
+        int tail = 0;
+
+        dist[from] = 0;
+        hop[from] = from;
+        queue[tail++] = from;
+
+        // Standard BFS, the first hop is inherited from the room we came through
+        while(head < tail) {
+            int curr = queue[head++];
+            RoomNodeType *node = house->roomIndex[curr]->connectedRooms->head;
+
+            while(node != NULL) {
+                int next = node->data->id;
+                if(dist[next] == PATH_NONE) {
+                    dist[next] = dist[curr] + 1;
+                    hop[next] = curr == from ? next : hop[curr];
+                    queue[tail++] = next;
+                }
+                node = node->next;
+            }
+        }
+    }
+
+    free(queue);
+    return table;
+}
+
+/*  Function: pathDistance()
+    Description: Returns the number of moves between two rooms
+
+    in: PathTableType *table - Pointer to the table to read from
+    in: int from - Index of the starting room
+    in: int to - Index of the destination room
+
+    Returns: int - The number of moves, or -1 if the room can not be reached
+*/
+int pathDistance(PathTableType *table, int from, int to) {
+    if (!table) return -1; // Check for NULL pointer
+    unsigned short dist = table->dist[from * table->size + to];
+    return dist == PATH_NONE ? -1 : dist;
+}
+
+/*  Function: pathNextRoom()
+    Description: Returns the connected room to move into to get closer to the target
+
+    in: HouseType *house - Pointer to the house containing both rooms
+    in: RoomType *from - Pointer to the room to move from
+    in: RoomType *to - Pointer to the room to move towards
+
+    Returns: RoomType* - Pointer to the next room, NULL if the target can not be reached
+*/
+RoomType* pathNextRoom(HouseType *house, RoomType *from, RoomType *to) {
+    if (!house || !house->paths || !from || !to) return NULL; // Check for NULL pointers
+    PathTableType *table = house->paths;
+    unsigned short hop = table->nextHop[from->id * table->size + to->id];
+
+    if(hop == PATH_NONE) return NULL;
+    return house->roomIndex[hop];
+}
+
+/*  Function: cleanupPathTable()
+    Description: Frees all dynamically allocated memory in the PathTableType struct
+
+    in/out: PathTableType *table - Pointer to the PathTableType struct to free
+
+    Returns: None
+*/
+void cleanupPathTable(PathTableType *table) {
+    if (!table) return; // Check for NULL pointer
+    free(table->dist);
+    free(table->nextHop);
+    free(table);
+}
@@ -0,0 +1,132 @@
+#include "defs.h"
+
+#ifdef PROFILE
+
+#define PROFILE_DEPTH   8
+
+// Counters of one thread, only that thread writes them so no locking is needed while it runs
+typedef struct {
+    long long ns[PROF_SECTION_COUNT];
+    long calls[PROF_SECTION_COUNT];
+    ProfileSection stack[PROFILE_DEPTH];
+    int depth;
+    struct timespec last;
+} ProfileThreadType;
+
+static __thread ProfileThreadType prof;
+
+// Totals of every thread that has finished, threads add to them with atomics when they exit
+static long long totalNs[PROF_SECTION_COUNT];
+static long totalCalls[PROF_SECTION_COUNT];
+static long totalThreads;
+
+static const char *sectionNames[PROF_SECTION_COUNT] = {
+    "Sleeping", "Waiting on locks", "Logging", "Loop overhead",
+    "Hunter move", "Hunter collect", "Hunter review", "Ghost move", "Ghost drop"
+};
+
+/*  Function: profileCharge()
+    Description: Adds the time since the last switch to the section on top of the stack
+
+    in: None
+
+    Returns: None
+*/
+static void profileCharge() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    prof.ns[prof.stack[prof.depth - 1]] += (now.tv_sec - prof.last.tv_sec) * 1000000000LL + (now.tv_nsec - prof.last.tv_nsec);
+    prof.last = now;
+}
+
+/*  Function: profileThreadStart()
+    Description: Resets the calling thread's counters, time is charged to loop overhead until a section begins
+
+    in: None
+
+    Returns: None
+*/
+void profileThreadStart() {
+    memset(&prof, 0, sizeof(prof));
+    prof.stack[0] = PROF_OVERHEAD;
+    prof.depth = 1;
+    clock_gettime(CLOCK_MONOTONIC, &prof.last);
+}
+
+/*  Function: profileBegin()
+    Description: Starts charging time to a section, sections nest so a lock wait inside
+                 an action is not counted as part of the action
+
+    in: ProfileSection section - The section being entered
+
+    Returns: None
+*/
+void profileBegin(ProfileSection section) {
+    if (prof.depth == 0 || prof.depth == PROFILE_DEPTH) return; // Not started or nested too deep
+    profileCharge();
+    prof.stack[prof.depth++] = section;
+    prof.calls[section]++;
+}
+
+/*  Function: profileEnd()
+    Description: Stops charging time to the current section and returns to the one it was nested in
+
+    in: None
+
+    Returns: None
+*/
+void profileEnd() {
+    if (prof.depth <= 1) return; // Nothing to end
+    profileCharge();
+    prof.depth--;
+}
+
+/*  Function: profileThreadDone()
+    Description: Adds the calling thread's counters to the totals
+
+    in: None
+
+    Returns: None
+*/
+void profileThreadDone() {
+    if (prof.depth == 0) return; // Never started
+    profileCharge();
+    for(int i = 0; i < PROF_SECTION_COUNT; i++) {
+        __atomic_add_fetch(&totalNs[i], prof.ns[i], __ATOMIC_RELAXED);
+        __atomic_add_fetch(&totalCalls[i], prof.calls[i], __ATOMIC_RELAXED);
+    }
+    __atomic_add_fetch(&totalThreads, 1, __ATOMIC_RELAXED);
+    prof.depth = 0;
+}
+
+/*  Function: profileReport()
+    Description: Prints where the time of every finished thread went, the work sections together
+                 with the loop overhead make up the time spent doing work
+
+    in/out: FILE *out - The file to print to
+
+    Returns: None
+*/
+void profileReport(FILE *out) {
+    long long all = 0;
+    long long work = 0;
+    for(int i = 0; i < PROF_SECTION_COUNT; i++) {
+        all += totalNs[i];
+        if(i >= PROF_OVERHEAD) work += totalNs[i];
+    }
+    if(all == 0) return;
+
+    fprintf(out, "--------------------------------\n");
+    fprintf(out, "Profile over %ld threads, %.1f ms of thread time\n", totalThreads, all / 1e6);
+    fprintf(out, "--------------------------------\n");
+    fprintf(out, "%-24s %10s %12s %8s %10s\n", "Section", "Calls", "Total ms", "Share", "Avg us");
+    for(int i = 0; i < PROF_SECTION_COUNT; i++) {
+        double avg = totalCalls[i] ? totalNs[i] / 1e3 / totalCalls[i] : 0;
+        fprintf(out, "%-24s %10ld %12.2f %7.1f%% %10.2f\n", sectionNames[i], totalCalls[i], totalNs[i] / 1e6,
+            100.0 * totalNs[i] / all, avg);
+    }
+    fprintf(out, "\nSleeping %.1f%%, waiting on locks %.1f%%, working %.1f%%, logging %.1f%%\n\n",
+        100.0 * totalNs[PROF_SLEEP] / all, 100.0 * totalNs[PROF_LOCK] / all, 100.0 * work / all, 100.0 * totalNs[PROF_LOG] / all);
+}
+
+#endif
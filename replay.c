@@ -0,0 +1,578 @@
+#include "defs.h"
+
+/*
+    Replay mode rebuilds a game from its output.txt without starting any threads. Every logged event is
+    applied to a fresh house through the same room, evidence and review functions the threads use, and
+    is checked against the rules of the game on the way:
+
+        - a ghost only leaves evidence its class leaves, in the room it is in
+        - ghosts and hunters only move into a room connected to the one they are in
+        - a hunter only collects its own evidence type, in its room, and never after it exited
+        - every piece of evidence collected was left by a ghost and the final evidence list matches
+
+    Lines are written after the locks are released, so a collect can be logged just before the drop it
+    took. That evidence is owed to the room and paid back by the next matching drop, anything still owed
+    at the end is an error. Evidence that expired is never logged and simply stays in the room.
+
+    Ghost lines carry no ghost id, so each ghost is tracked as the set of rooms it could be in. A ghost
+    line is only an error when no ghost could have written it, and when exactly one could, that ghost's
+    room is known again. With a single ghost every line is checked exactly.
+    Reviews are replayed against the config given on the command line, a review that comes out
+    differently from the log is counted as a mismatch rather than an error since it depends on when
+    the review ran relative to other hunters' collects. A review breaks ties between ghost classes by
+    taking the first, so replaying draws nothing from the RNG.
+*/
+
+// Only the first few errors are printed, the rest are counted
+#define REPLAY_SHOWN    10
+
+/*  Function: replayError()
+    Description: Counts an event that broke the rules and prints the first few
+
+    in/out: ReplayType *replay - The replay the event belongs to
+    in: const char *message - What was wrong
+    in: const char *name - The hunter, room or evidence it was found on
+
+    Returns: None
+*/
+static void replayError(ReplayType *replay, const char *message, const char *name) {
+    replay->errors++;
+    if(replay->errors <= REPLAY_SHOWN) printf("[REPLAY] line %d: %s: %s\n", replay->line, message, name);
+}
+
+/*  Function: findRoom()
+    Description: Finds a room of the house by name
+
+    in: HouseType *house - The house to search
+    in: const char *name - The room's name
+
+    Returns: RoomType* - The room, NULL if the house has no room with that name
+*/
+static RoomType* findRoom(HouseType *house, const char *name) {
+    for(int i = 0; i < house->roomCount; i++) {
+        if(strcmp(house->roomIndex[i]->name, name) == 0) return house->roomIndex[i];
+    }
+    return NULL;
+}
+
+/*  Function: findHunter()
+    Description: Finds a hunter of the house by name
+
+    in: HouseType *house - The house to search
+    in: const char *name - The hunter's name
+
+    Returns: HunterType* - The hunter, NULL if no hunter has that name
+*/
+static HunterType* findHunter(HouseType *house, const char *name) {
+    HunterListType *hunters = house->hunterList;
+    for(int i = 0; i < hunters->size; i++) {
+        if(strcmp(hunters->hunters[i]->name, name) == 0) return hunters->hunters[i];
+    }
+    return NULL;
+}
+
+/*  Function: isConnected()
+    Description: Checks if one room connects to another
+
+    in: RoomType *from - The room being left
+    in: RoomType *to - The room being entered
+
+    Returns: int - C_TRUE if the rooms are connected, C_FALSE otherwise
+*/
+static int isConnected(RoomType *from, RoomType *to) {
+    for(RoomNodeType *node = from->connectedRooms->head; node; node = node->next) {
+        if(node->data == to) return C_TRUE;
+    }
+    return C_FALSE;
+}
+
+/*  Function: parseEvidenceName()
+    Description: Converts an evidence name from the log to its type
+
+    in: const char *name - The name, e.g. "EMF"
+
+    Returns: EvidenceType - The evidence type, EV_UNKNOWN if the name is not one
+*/
+static EvidenceType parseEvidenceName(const char *name) {
+    for(int ev = 0; ev < EV_COUNT; ev++) {
+        if(strcmp(name, evidenceName(ev)) == 0) return (EvidenceType) ev;
+    }
+    return EV_UNKNOWN;
+}
+
+/*  Function: ghostRoomSet()
+    Description: The rooms a ghost could be in, one flag per room id
+
+    in: ReplayType *replay - The replay the ghost belongs to
+    in: int ghost - The ghost's id
+
+    Returns: unsigned char* - The ghost's house->roomCount flags
+*/
+static unsigned char* ghostRoomSet(ReplayType *replay, int ghost) {
+    return replay->ghostRooms + ghost * replay->house->roomCount;
+}
+
+/*  Function: placeGhost()
+    Description: Records that a ghost is known to be in one room
+
+    in/out: ReplayType *replay - The replay the ghost belongs to
+    in/out: GhostType *ghost - The ghost
+    in: RoomType *room - The room it is in
+
+    Returns: None
+*/
+static void placeGhost(ReplayType *replay, GhostType *ghost, RoomType *room) {
+    unsigned char *rooms = ghostRoomSet(replay, ghost->id);
+    memset(rooms, 0, replay->house->roomCount);
+    rooms[room->id] = C_TRUE;
+    ghost->currentRoom = room;
+}
+
+/*  Function: replayGhostInit()
+    Description: Creates a ghost of the logged class in the logged room
+
+    in/out: ReplayType *replay - The replay to add the ghost to
+    in: const char *body - The line after its tag
+
+    Returns: None
+*/
+static void replayGhostInit(ReplayType *replay, const char *body) {
+    char className[MAX_STR], roomName[MAX_STR];
+    if(sscanf(body, "Ghost is a [%63[^]]] in room [%63[^]]]", className, roomName) != 2) {
+        replayError(replay, "unreadable ghost", body);
+        return;
+    }
+    GhostClass class = GH_UNKNOWN;
+    for(int c = 0; c < GHOST_COUNT; c++) {
+        if(strcmp(className, ghostName(c)) == 0) class = (GhostClass) c;
+    }
+    RoomType *room = findRoom(replay->house, roomName);
+    if(class == GH_UNKNOWN || !room) {
+        replayError(replay, "unknown ghost class or room", body);
+        return;
+    }
+    if(replay->house->hunterList->size > 0) replayError(replay, "ghost created after the hunters", className);
+
+    GhostType *ghost;
+    createGhost(replay->house, &ghost, class, room, replay->config);
+
+    // Grow the room sets by one ghost
+    int roomCount = replay->house->roomCount;
+    unsigned char *ghostRooms = safeMalloc(roomCount * replay->house->ghostList->size);
+    if(replay->ghostRooms) memcpy(ghostRooms, replay->ghostRooms, roomCount * ghost->id);
+    free(replay->ghostRooms);
+    replay->ghostRooms = ghostRooms;
+    placeGhost(replay, ghost, room);
+}
+
+/*  Function: replayHunterInit()
+    Description: Creates a hunter with the logged equipment in the van
+
+    in/out: ReplayType *replay - The replay to add the hunter to
+    in: const char *body - The line after its tag
+
+    Returns: None
+*/
+static void replayHunterInit(ReplayType *replay, const char *body) {
+    char name[MAX_STR], evName[MAX_STR];
+    if(sscanf(body, "[%63[^]]] is a [%63[^]]] hunter", name, evName) != 2) {
+        replayError(replay, "unreadable hunter", body);
+        return;
+    }
+    EvidenceType ev = parseEvidenceName(evName);
+    if(ev == EV_UNKNOWN) {
+        replayError(replay, "unknown evidence", evName);
+        return;
+    }
+    if(findHunter(replay->house, name)) {
+        replayError(replay, "hunter created twice", name);
+        return;
+    }
+
+    HunterType *hunter;
+    int id = replay->house->hunterList->size + 1;
+    initHunter(&hunter, replay->house->ghostList, replay->house, name, &id, ev, replay->config);
+    addHunter(replay->house->hunterList, hunter);
+}
+
+/*  Function: replayGhostMove()
+    Description: Moves whichever ghosts could have made the logged move
+
+    in/out: ReplayType *replay - The replay to apply the move to
+    in: const char *body - The line after its tag
+
+    Returns: None
+*/
+static void replayGhostMove(ReplayType *replay, const char *body) {
+    char roomName[MAX_STR];
+    RoomType *room = NULL;
+    if(sscanf(body, "Ghost has moved into [%63[^]]]", roomName) != 1 || !(room = findRoom(replay->house, roomName))) {
+        replayError(replay, "unreadable ghost move", body);
+        return;
+    }
+
+    GhostListType *ghosts = replay->house->ghostList;
+    int candidates = 0, last = -1;
+    for(int i = 0; i < ghosts->size; i++) {
+        if(ghosts->ghosts[i]->exited) continue;
+        // Rooms are connected both ways so the ghost came from one of the new room's neighbours
+        unsigned char *rooms = ghostRoomSet(replay, i);
+        int nextTo = C_FALSE;
+        for(RoomNodeType *node = room->connectedRooms->head; node && !nextTo; node = node->next) nextTo = rooms[node->data->id];
+        if(!nextTo) continue;
+        // It either made this move or is still where it was
+        rooms[room->id] = C_TRUE;
+        candidates++;
+        last = i;
+    }
+    if(candidates == 0) {
+        replayError(replay, "no ghost is next to", roomName);
+    } else if(candidates == 1) {
+        placeGhost(replay, ghosts->ghosts[last], room);
+    }
+}
+
+/*  Function: replayDrop()
+    Description: Adds pieces of logged evidence to a room, paying back any that was collected first
+
+    in/out: ReplayType *replay - The replay to apply the drop to
+    in: RoomType *room - The room the evidence was left in
+    in: EvidenceType ev - The evidence that was left
+    in: int count - How many pieces were left
+
+    Returns: None
+*/
+static void replayDrop(ReplayType *replay, RoomType *room, EvidenceType ev, int count) {
+    // A ghost that leaves that evidence has to be able to be in the room, the first one is credited
+    GhostListType *ghosts = replay->house->ghostList;
+    GhostType *ghost = NULL;
+    int candidates = 0;
+    for(int i = 0; i < ghosts->size; i++) {
+        GhostType *candidate = ghosts->ghosts[i];
+        if(candidate->exited || !ghostRoomSet(replay, i)[room->id] || !(ghostEvidence(candidate->class) & EV_BIT(ev))) continue;
+        if(!ghost) ghost = candidate;
+        candidates++;
+    }
+    if(!ghost) {
+        replayError(replay, "no ghost in the room leaves", evidenceName(ev));
+    } else if(candidates == 1) {
+        placeGhost(replay, ghost, room);
+    }
+
+    int *owed = &replay->owed[room->id * EV_COUNT + ev];
+    for(int i = 0; i < count; i++) {
+        if(*owed > 0) {
+            (*owed)--;
+        } else {
+            addSourcedEvidence(room->evidenceList, ev, ghost ? ghost->id : -1, 0);
+        }
+    }
+    room->evDrops[ev] += count;
+}
+
+/*  Function: replayGhostEvidence()
+    Description: Applies a logged drop, either one piece or a batch of "[TYPE xN]" groups
+
+    in/out: ReplayType *replay - The replay to apply the drop to
+    in: const char *body - The line after its tag
+
+    Returns: None
+*/
+static void replayGhostEvidence(ReplayType *replay, const char *body) {
+    const char *prefix = "Ghost left ";
+    if(strncmp(body, prefix, strlen(prefix)) != 0) {
+        replayError(replay, "unreadable ghost evidence", body);
+        return;
+    }
+
+    // Every group is read before any is applied, the room comes last
+    int counts[EV_COUNT] = {0};
+    const char *p = body + strlen(prefix);
+    while(*p == '[') {
+        char group[MAX_STR], evName[MAX_STR];
+        int count = 1, used;
+        if(sscanf(p, "[%63[^]]]%n", group, &used) != 1) break;
+        if(sscanf(group, "%63s x%d", evName, &count) < 1) break;
+        EvidenceType ev = parseEvidenceName(evName);
+        if(ev == EV_UNKNOWN || count <= 0) {
+            replayError(replay, "unknown evidence", group);
+            return;
+        }
+        counts[ev] += count;
+        p += used;
+        if(*p == ' ' && p[1] == '[') p++;
+    }
+
+    char roomName[MAX_STR];
+    RoomType *room = NULL;
+    if(sscanf(p, " in [%63[^]]]", roomName) != 1 || !(room = findRoom(replay->house, roomName))) {
+        replayError(replay, "unreadable ghost evidence", body);
+        return;
+    }
+    for(int ev = 0; ev < EV_COUNT; ev++) {
+        if(counts[ev] > 0) replayDrop(replay, room, (EvidenceType) ev, counts[ev]);
+    }
+}
+
+/*  Function: replayHunterMove()
+    Description: Moves a hunter into the logged room
+
+    in/out: ReplayType *replay - The replay to apply the move to
+    in: const char *body - The line after its tag
+
+    Returns: None
+*/
+static void replayHunterMove(ReplayType *replay, const char *body) {
+    char name[MAX_STR], roomName[MAX_STR];
+    HunterType *hunter = NULL;
+    RoomType *room = NULL;
+    if(sscanf(body, "[%63[^]]] has moved into [%63[^]]]", name, roomName) != 2 ||
+       !(hunter = findHunter(replay->house, name)) || !(room = findRoom(replay->house, roomName))) {
+        replayError(replay, "unreadable hunter move", body);
+        return;
+    }
+    if(hunter->exitReason != LOG_UNKNOWN) {
+        replayError(replay, "hunter moved after exiting", name);
+        return;
+    }
+    if(!isConnected(hunter->room, room)) replayError(replay, "hunter moved to a room that is not connected", name);
+
+    roomRemoveHunter(hunter->room, hunter);
+    hunter->room = room;
+    roomAddHunter(room, hunter);
+    room->visits++;
+    hunter->moves++;
+}
+
+/*  Function: replayHunterEvidence()
+    Description: Moves the logged evidence from the hunter's room to the shared evidence
+
+    in/out: ReplayType *replay - The replay to apply the collect to
+    in: const char *body - The line after its tag
+
+    Returns: None
+*/
+static void replayHunterEvidence(ReplayType *replay, const char *body) {
+    char name[MAX_STR], evName[MAX_STR], roomName[MAX_STR];
+    int count = 1;
+    HunterType *hunter = NULL;
+    RoomType *room = NULL;
+    if(sscanf(body, "[%63[^]]] found [%63[^]]] x%d in [%63[^]]]", name, evName, &count, roomName) != 4 &&
+       sscanf(body, "[%63[^]]] found [%63[^]]] in [%63[^]]]", name, evName, roomName) != 3) {
+        replayError(replay, "unreadable hunter evidence", body);
+        return;
+    }
+    EvidenceType ev = parseEvidenceName(evName);
+    if(!(hunter = findHunter(replay->house, name)) || !(room = findRoom(replay->house, roomName)) || ev == EV_UNKNOWN || count <= 0) {
+        replayError(replay, "unreadable hunter evidence", body);
+        return;
+    }
+    if(hunter->exitReason != LOG_UNKNOWN) replayError(replay, "hunter collected after exiting", name);
+    if(hunter->room != room) replayError(replay, "hunter collected in a room it is not in", name);
+    if(hunter->evidence != ev) replayError(replay, "hunter collected evidence it can not detect", name);
+
+    for(int i = 0; i < count; i++) {
+        int source = -1;
+        if(takeEvidence(room->evidenceList, ev, &source) == EV_UNKNOWN) {
+            // Not dropped yet as far as the log goes, credit it to a ghost that leaves it
+            replay->owed[room->id * EV_COUNT + ev]++;
+            GhostListType *ghosts = replay->house->ghostList;
+            for(int g = ghosts->size - 1; g >= 0; g--) {
+                if(ghostEvidence(ghosts->ghosts[g]->class) & EV_BIT(ev)) source = g;
+            }
+        }
+        addSourcedEvidence(replay->house->evidence, ev, source, 0);
+    }
+}
+
+/*  Function: replayHunterReview()
+    Description: Runs the hunter's review on the replayed evidence and compares it with the log
+
+    in/out: ReplayType *replay - The replay to apply the review to
+    in: const char *body - The line after its tag
+
+    Returns: None
+*/
+static void replayHunterReview(ReplayType *replay, const char *body) {
+    char name[MAX_STR], result[MAX_STR];
+    HunterType *hunter = NULL;
+    if(sscanf(body, "[%63[^]]] reviewed evidence and found [%63[^]]]", name, result) != 2 || !(hunter = findHunter(replay->house, name))) {
+        replayError(replay, "unreadable hunter review", body);
+        return;
+    }
+    if(hunter->exitReason != LOG_UNKNOWN) replayError(replay, "hunter reviewed after exiting", name);
+
+    int sufficient = review(hunter);
+    if(sufficient != (strcmp(result, "SUFFICIENT") == 0)) replay->mismatches++;
+}
+
+/*  Function: replayHunterExit()
+    Description: Takes a hunter out of the house
+
+    in/out: ReplayType *replay - The replay to apply the exit to
+    in: const char *body - The line after its tag
+
+    Returns: None
+*/
+static void replayHunterExit(ReplayType *replay, const char *body) {
+    char name[MAX_STR], reason[MAX_STR];
+    HunterType *hunter = NULL;
+    if(sscanf(body, "[%63[^]]] exited because [%63[^]]]", name, reason) != 2 || !(hunter = findHunter(replay->house, name))) {
+        replayError(replay, "unreadable hunter exit", body);
+        return;
+    }
+    enum LoggerDetails exitReason = LOG_EVIDENCE;
+    if(strcmp(reason, "FEAR") == 0) exitReason = LOG_FEAR;
+    if(strcmp(reason, "BORED") == 0) exitReason = LOG_BORED;
+
+    // A hunter logs every reason it has for leaving, evidence first, then boredom, then fear
+    if(hunter->exitReason == LOG_UNKNOWN) {
+        hunterExit(hunter);
+    } else if(exitReason >= hunter->exitReason) {
+        replayError(replay, "hunter exited twice", name);
+        return;
+    }
+    hunter->exitReason = exitReason;
+}
+
+/*  Function: replayGhostExit()
+    Description: Takes a ghost out of the house, which one is only known once a single ghost is left
+
+    in/out: ReplayType *replay - The replay to apply the exit to
+
+    Returns: None
+*/
+static void replayGhostExit(ReplayType *replay) {
+    GhostListType *ghosts = replay->house->ghostList;
+    int remaining = 0, last = -1;
+    for(int i = 0; i < ghosts->size; i++) {
+        if(ghosts->ghosts[i]->exited) continue;
+        remaining++;
+        last = i;
+    }
+
+    if(remaining - replay->ghostExits <= 0) {
+        replayError(replay, "more ghosts exited than were created", "Ghost");
+    } else if(remaining == 1) {
+        ghosts->ghosts[last]->exited = C_TRUE;
+    } else {
+        replay->ghostExits++;
+    }
+}
+
+/*  Function: replayLine()
+    Description: Applies one line of the log
+
+    in/out: ReplayType *replay - The replay to apply the line to
+    in: const char *line - The line without its newline
+
+    Returns: None
+*/
+static void replayLine(ReplayType *replay, const char *line) {
+    // The final results are only read for the evidence the hunters found
+    if(replay->summary) {
+        EvidenceType ev;
+        if(strncmp(line, " - ", 3) == 0 && (ev = parseEvidenceName(line + 3)) != EV_UNKNOWN) {
+            replay->summaryEv[ev]++;
+        } else {
+            replay->summary = C_FALSE;
+        }
+        return;
+    }
+    if(strncmp(line, "Hunters found the following evidence:", 37) == 0) {
+        replay->summary = C_TRUE;
+        return;
+    }
+    if(line[0] != '[') return;
+
+    // Every tag is padded to the same width so the body always starts at the same column
+    const char *body = line + 18;
+    if(strlen(line) < 18) {
+        replayError(replay, "unreadable line", line);
+        return;
+    }
+    replay->events++;
+    if(strncmp(line, "[GHOST INIT]", 12) == 0) replayGhostInit(replay, body);
+    else if(strncmp(line, "[HUNTER INIT]", 13) == 0) replayHunterInit(replay, body);
+    else if(strncmp(line, "[GHOST MOVE]", 12) == 0) replayGhostMove(replay, body);
+    else if(strncmp(line, "[GHOST EVIDENCE]", 16) == 0) replayGhostEvidence(replay, body);
+    else if(strncmp(line, "[GHOST EXIT]", 12) == 0) replayGhostExit(replay);
+    else if(strncmp(line, "[HUNTER MOVE]", 13) == 0) replayHunterMove(replay, body);
+    else if(strncmp(line, "[HUNTER EVIDENCE]", 17) == 0) replayHunterEvidence(replay, body);
+    else if(strncmp(line, "[HUNTER REVIEW]", 15) == 0) replayHunterReview(replay, body);
+    else if(strncmp(line, "[HUNTER EXIT]", 13) == 0) replayHunterExit(replay, body);
+    else replayError(replay, "unknown event", line);
+}
+
+/*  Function: replayFinish()
+    Description: Checks what has to hold once the whole log was applied
+
+    in/out: ReplayType *replay - The finished replay
+
+    Returns: None
+*/
+static void replayFinish(ReplayType *replay) {
+    HouseType *house = replay->house;
+    for(int i = 0; i < house->roomCount; i++) {
+        for(int ev = 0; ev < EV_COUNT; ev++) {
+            if(replay->owed[i * EV_COUNT + ev] > 0) replayError(replay, "evidence collected that was never left", house->roomIndex[i]->name);
+        }
+    }
+
+    // Only the counts are compared, the shared list is in the order the collects were logged
+    int found[EV_COUNT] = {0};
+    for(EvidenceNodeType *node = house->evidence->head; node; node = node->next) found[node->data]++;
+    for(int ev = 0; ev < EV_COUNT; ev++) {
+        if(found[ev] != replay->summaryEv[ev]) replayError(replay, "final evidence does not match", evidenceName(ev));
+    }
+}
+
+/*  Function: runReplay()
+    Description: Replays the log at config->replayPath and prints how many events broke the rules
+
+    in: const ConfigType *config - The parameters reviews are replayed with
+
+    Returns: int - C_TRUE if every event could be replayed, C_FALSE otherwise
+*/
+int runReplay(const ConfigType *config) {
+    FILE *file = fopen(config->replayPath, "r");
+    if(!file) {
+        printf("Could not open %s\n", config->replayPath);
+        return C_FALSE;
+    }
+
+    // Nothing replayed may end up in the log being read
+    l_setLogging(C_FALSE);
+
+    ReplayType replay;
+    memset(&replay, 0, sizeof(replay));
+    replay.config = config;
+    initHouse(&replay.house);
+    replay.house->game->replaying = C_TRUE;
+    populateRooms(replay.house);
+    replay.house->hunterList = createHunterList();
+    replay.owed = safeMalloc(sizeof(int) * replay.house->roomCount * EV_COUNT);
+    memset(replay.owed, 0, sizeof(int) * replay.house->roomCount * EV_COUNT);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    char line[MAX_STR * 8];
+    while(fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\n")] = '\0';
+        replay.line++;
+        replayLine(&replay, line);
+    }
+    replayFinish(&replay);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    fclose(file);
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("[REPLAY] %ld events, %ld errors, %ld review mismatches in %.3fs (%.0f events/s)\n", replay.events,
+        replay.errors, replay.mismatches, seconds, seconds > 0 ? replay.events / seconds : 0.0);
+
+    int passed = replay.errors == 0;
+    free(replay.owed);
+    free(replay.ghostRooms);
+    cleanupHouse(replay.house);
+    return passed;
+}
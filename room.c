@@ -67,6 +67,9 @@ struct Room* createRoom(char* name) {
     if (!newRoom) return NULL; // Check if memory allocation was successful
 
     strcpy(newRoom->name, name);
+    newRoom->id = -1;
+    memset(newRoom->evDrops, 0, sizeof(newRoom->evDrops));
+    newRoom->visits = 0;
     newRoom->connectedRooms = createConnectedRoomList();
     if (!newRoom->connectedRooms) { // Check if connected room list creation was successful
         free(newRoom);
@@ -78,7 +81,8 @@ struct Room* createRoom(char* name) {
         free(newRoom);
         return NULL;
     }
-    newRoom->ghost = NULL;
+    newRoom->ghostCount = 0;
+    newRoom->hunterCount = 0;
     newRoom->hunterList = createHunterList();
     if (!newRoom->hunterList) { // Check if hunter list creation was successful
         cleanupEvidenceList(newRoom->evidenceList);
@@ -114,7 +118,7 @@ RoomListType* createConnectedRoomList() {
     Returns: RoomType* - Pointer to the room if found, NULL otherwise
 */
 RoomType* findRandomConnectedRoom(RoomType *currentRoom) {
-    if (!currentRoom) return NULL; // Check for NULL pointer
+    if (!currentRoom || currentRoom->connectedRooms->size == 0) return NULL; // Check for NULL pointer or no connections
     RoomListType *roomList = currentRoom->connectedRooms;
     int roomIndex = randInt(0, roomList->size);
     RoomNodeType *room = roomList->head;
@@ -127,6 +131,78 @@ RoomType* findRandomConnectedRoom(RoomType *currentRoom) {
     return room->data;
 }
 
+/*  Function: roomAddHunter()
+    Description: Adds the hunter to the room's occupants, the caller must hold the room's semaphore
+
+    in/out: RoomType *room - Pointer to the room the hunter is entering
+    in/out: HunterType *hunter - Pointer to the hunter, remembers its slot in the room
+
+    Returns: None
+*/
+void roomAddHunter(RoomType *room, HunterType *hunter) {
+    if (!room || !hunter) return; // Check for NULL pointers
+    hunter->roomSlot = room->hunterList->size;
+    addHunter(room->hunterList, hunter);
+    __atomic_add_fetch(&room->hunterCount, 1, __ATOMIC_SEQ_CST);
+}
+
+/*  Function: roomRemoveHunter()
+    Description: Removes the hunter from the room's occupants in constant time by moving the last
+                 occupant into its slot, the caller must hold the room's semaphore
+
+    in/out: RoomType *room - Pointer to the room the hunter is leaving
+    in/out: HunterType *hunter - Pointer to the hunter to remove
+
+    Returns: None
+*/
+void roomRemoveHunter(RoomType *room, HunterType *hunter) {
+    if (!room || !hunter) return; // Check for NULL pointers
+    HunterListType *list = room->hunterList;
+    int slot = hunter->roomSlot;
+    if (slot < 0 || slot >= list->size || list->hunters[slot] != hunter) return; // Not in this room
+
+    HunterType *last = list->hunters[list->size - 1];
+    list->hunters[slot] = last;
+    last->roomSlot = slot;
+    list->size--;
+    hunter->roomSlot = -1;
+    __atomic_sub_fetch(&room->hunterCount, 1, __ATOMIC_SEQ_CST);
+}
+
+/*  Function: expireRoomEvidence()
+    Description: Removes the room's evidence that has outlived config->evLifetime or does not fit in
+                 config->roomCapacity, the caller must hold the room's semaphore
+
+    in/out: RoomType *room - Pointer to the room to expire evidence from
+    in/out: GameStateType *game - Pointer to the game that counts the expired evidence
+    in: const ConfigType *config - The simulation parameters
+
+    Returns: None
+*/
+void expireRoomEvidence(RoomType *room, GameStateType *game, const ConfigType *config) {
+    if (!room || !config || (config->evLifetime == 0 && config->roomCapacity == 0)) return; // Nothing expires
+    int expired = expireEvidence(room->evidenceList, gameTime(game), config->evLifetime, config->roomCapacity);
+    if(expired > 0) gameEvidenceExpired(game, expired);
+}
+
+/*  Function: resetRoom()
+    Description: Empties the room for a new game, its name and connections are kept
+
+    in/out: RoomType *room - Pointer to the room to reset
+
+    Returns: None
+*/
+void resetRoom(RoomType *room) {
+    if (!room) return; // Check for NULL pointer
+    clearEvidenceList(room->evidenceList);
+    // The hunters themselves belong to the house's hunter list
+    room->hunterList->size = 0;
+    room->hunterCount = 0;
+    room->ghostCount = 0;
+    memset(room->evDrops, 0, sizeof(room->evDrops));
+    room->visits = 0;
+}
+
 /*  Function: cleanupRoomListData()
     Description: Frees all dynamically allocated memory in the RoomListType struct
 
@@ -142,7 +218,9 @@ void cleanupRoomListData(RoomListType* list) {
     while(currentNode != NULL) {
         cleanupEvidenceList(currentNode->data->evidenceList);
         cleanupRoomList(currentNode->data->connectedRooms);
-        cleanupHunterList(currentNode->data->hunterList);
+        // The room only refers to the hunters, they are freed with the house's hunter list
+        free(currentNode->data->hunterList->hunters);
+        free(currentNode->data->hunterList);
         free(currentNode->data);
         currentNode = currentNode->next;
     }
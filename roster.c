@@ -0,0 +1,215 @@
+#include "defs.h"
+#include <ctype.h>
+
+/*
+    Roster format, a stream of whitespace separated words so one word per line works as well:
+
+        <name> <evidence> [key=value]... <name> <evidence> [key=value]...
+
+    The evidence is its number (0 - EMF, 1 - TEMPERATURE, 2 - FINGERPRINTS, 3 - SOUND) or its name.
+    The optional keys are fear_max, boredom_max and policy. As with the prompts, no evidence type
+    can repeat until every type has been handed out. Names can not contain '=' since a word with one
+    is read as an option.
+*/
+
+/*  Function: parseEvidence()
+    Description: Converts a roster word to an evidence type
+
+    in: const char *word - The evidence number or name
+    out: EvidenceType *ev - The evidence type
+
+    Returns: int - C_TRUE if the word named an evidence type, C_FALSE otherwise
+*/
+static int parseEvidence(const char *word, EvidenceType *ev) {
+    for(int i = 0; i < EV_COUNT; i++) {
+        if(strcmp(word, evidenceName(i)) == 0 || (word[0] == '0' + i && word[1] == '\0')) {
+            *ev = (EvidenceType) i;
+            return C_TRUE;
+        }
+    }
+    return C_FALSE;
+}
+
+/*  Function: readWord()
+    Description: Reads the next whitespace separated word, like fscanf(" %63s") but counting the lines it passes
+
+    in/out: FILE *file - The file to read from
+    out: char *word - The word, at most MAX_STR - 1 characters
+    in/out: int *line - The current line number, moved past every newline before the word
+
+    Returns: int - C_TRUE if a word was read, C_FALSE at the end of the file
+*/
+static int readWord(FILE *file, char *word, int *line) {
+    int c;
+    while((c = fgetc(file)) != EOF && isspace(c)) {
+        if(c == '\n') (*line)++;
+    }
+    if(c == EOF) return C_FALSE;
+
+    int len = 0;
+    while(c != EOF && !isspace(c) && len < MAX_STR - 1) {
+        word[len++] = (char) c;
+        c = fgetc(file);
+    }
+    // The character that ended the word is left for the next read so its newline is counted there
+    if(c != EOF) ungetc(c, file);
+    word[len] = '\0';
+    return C_TRUE;
+}
+
+/*  Function: isOption()
+    Description: Checks if a word is one of the roster's key=value options, whatever its value
+
+    in: const char *word - The word to check
+
+    Returns: int - C_TRUE if the word starts with a known key and '=', C_FALSE otherwise
+*/
+static int isOption(const char *word) {
+    const char *keys[] = { "policy=", "fear_max=", "boredom_max=" };
+    for(int i = 0; i < 3; i++) {
+        if(strncmp(word, keys[i], strlen(keys[i])) == 0) return C_TRUE;
+    }
+    return C_FALSE;
+}
+
+/*  Function: parseOption()
+    Description: Applies one key=value word to a roster entry
+
+    in/out: RosterEntryType *entry - The hunter the option belongs to
+    in: const char *word - The key=value word
+
+    Returns: int - C_TRUE if the option was valid, C_FALSE otherwise
+*/
+static int parseOption(RosterEntryType *entry, const char *word) {
+    const char *value = strchr(word, '=') + 1;
+    int keyLen = value - word - 1;
+    // Limits have to be whole positive numbers, "10x" or "" is not read as 10 or 0
+    int number;
+    if(!parseInt(value, &number)) number = 0;
+
+    if(keyLen == 6 && strncmp(word, "policy", 6) == 0) {
+        entry->policy = policyFromString(value);
+        return entry->policy != MOVE_POLICY_COUNT;
+    }
+    if(keyLen == 8 && strncmp(word, "fear_max", 8) == 0 && number > 0) {
+        entry->fearMax = number;
+        return C_TRUE;
+    }
+    if(keyLen == 11 && strncmp(word, "boredom_max", 11) == 0 && number > 0) {
+        entry->boredomMax = number;
+        return C_TRUE;
+    }
+    return C_FALSE;
+}
+
+/*  Function: addRosterEntry()
+    Description: Adds a hunter with the default options to the end of the roster
+
+    in/out: RosterType *roster - The roster to add to
+    in: const char *name - The hunter's name
+
+    Returns: RosterEntryType* - Pointer to the new entry
+*/
+static RosterEntryType* addRosterEntry(RosterType *roster, const char *name) {
+    // Double the array when it is full
+    if(roster->size == roster->capacity) {
+        roster->capacity *= 2;
+        roster->entries = realloc(roster->entries, sizeof(RosterEntryType) * roster->capacity);
+        if(!roster->entries) {
+            printf("Out of memory.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    RosterEntryType *entry = &roster->entries[roster->size++];
+    strcpy(entry->name, name);
+    entry->evidence = EV_UNKNOWN;
+    entry->fearMax = 0;
+    entry->boredomMax = 0;
+    entry->policy = MOVE_POLICY_COUNT;
+    return entry;
+}
+
+/*  Function: loadRoster()
+    Description: Reads every hunter from a roster file in one pass and checks the evidence types
+                 follow the same rule as the prompts do
+
+    in: const char *path - Path of the roster file, "-" reads it from stdin
+    out: RosterType **roster - Pointer to the newly created roster
+
+    Returns: int - C_TRUE if the whole roster was valid, C_FALSE otherwise
+*/
+int loadRoster(const char *path, RosterType **roster) {
+    FILE *file = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if(!file) {
+        printf("Could not open roster %s\n", path);
+        return C_FALSE;
+    }
+
+    *roster = safeMalloc(sizeof(RosterType));
+    (*roster)->size = 0;
+    (*roster)->capacity = NUM_HUNTERS;
+    (*roster)->entries = safeMalloc(sizeof(RosterEntryType) * (*roster)->capacity);
+
+    char word[MAX_STR];
+    RosterEntryType *entry = NULL;
+    unsigned char takenEvidence = 0;
+    int valid = C_TRUE;
+    int line = 1;
+
+    while(valid && readWord(file, word, &line)) {
+        if(entry && entry->evidence == EV_UNKNOWN) {
+            // The word after a name is always the hunter's evidence
+            if(!parseEvidence(word, &entry->evidence)) {
+                printf("%s:%d: hunter %d [%s] has an invalid evidence type: %s\n", path, line, (*roster)->size, entry->name, word);
+                valid = C_FALSE;
+            } else if((takenEvidence >> entry->evidence) & 1) {
+                printf("%s:%d: hunter %d [%s] repeats evidence %s before every type was taken\n", path, line, (*roster)->size, entry->name, word);
+                valid = C_FALSE;
+            } else {
+                takenEvidence |= 1 << entry->evidence;
+                if(takenEvidence == (1 << EV_COUNT) - 1) takenEvidence = 0;
+            }
+        } else if(entry && isOption(word)) {
+            if(!parseOption(entry, word)) {
+                printf("%s:%d: hunter %d [%s] has an invalid option: %s\n", path, line, (*roster)->size, entry->name, word);
+                valid = C_FALSE;
+            }
+        } else if(strchr(word, '=')) {
+            // Any other word with '=' is where a name is expected, splitting it as an option would lose the hunter
+            printf("%s:%d: hunter %d has a name containing '=': %s\n", path, line, (*roster)->size + 1, word);
+            valid = C_FALSE;
+        } else {
+            entry = addRosterEntry(*roster, word);
+        }
+    }
+
+    if(valid && entry && entry->evidence == EV_UNKNOWN) {
+        printf("%s:%d: hunter %d [%s] has no evidence type\n", path, line, (*roster)->size, entry->name);
+        valid = C_FALSE;
+    }
+    if(valid && (*roster)->size == 0) {
+        printf("%s: the roster has no hunters\n", path);
+        valid = C_FALSE;
+    }
+
+    if(file != stdin) fclose(file);
+    if(!valid) {
+        cleanupRoster(*roster);
+        *roster = NULL;
+    }
+    return valid;
+}
+
+/*  Function: cleanupRoster()
+    Description: Frees the memory allocated for the roster
+
+    in/out: RosterType *roster - Pointer to the RosterType struct to free
+
+    Returns: None
+*/
+void cleanupRoster(RosterType *roster) {
+    if (!roster) return; // Check for NULL pointer
+    free(roster->entries);
+    free(roster);
+}
@@ -0,0 +1,337 @@
+#include "defs.h"
+
+#define SNAPSHOT_VERSION 5
+
+/*
+    Snapshot format, one record per line. Names are always last on their line so they can contain spaces.
+
+        snapshot <version>
+        game <solved> <dropped per evidence type> <collected per evidence type>
+        rooms <count>
+        room <visits> <drops per evidence type> <name>         (once per room, in house order)
+        links <count> <room index>...                          (after each room)
+        evidence <count> <evidence type>:<ghost id>:<age>...   (after each room)
+        shared <count> <evidence type>:<ghost id>:<age>...
+
+    Ages are in microseconds of game time, the game time of a restored game starts again at 0.
+        ghosts <count>
+        ghost <class> <room index> <boredom> <ticks> <exited> <identified> <deduced> <confidence> <seed>   (in id order)
+        hunters <count>
+        hunter <id> <room index> <evidence> <fear> <boredom> <fear max> <boredom max> <ticks> <sufficient> <exit reason> <policy> <seed> <moves> <name>
+        visited <visitedAt per room>                           (after each hunter)
+        seen <seenDrops per room>                              (after each hunter)
+*/
+
+/*  Function: writeEvidence()
+    Description: Writes an evidence list as "<label> <count> <type>:<source>:<age>..."
+
+    in/out: FILE *file - The file to write to
+    in: const char *label - The record name
+    in: EvidenceListType *list - The list to write
+    in: long long now - The game time the snapshot is taken at
+
+    Returns: None
+*/
+static void writeEvidence(FILE *file, const char *label, EvidenceListType *list, long long now) {
+    fprintf(file, "%s %d", label, list->size);
+    for(EvidenceNodeType *node = list->head; node != NULL; node = node->next) {
+        fprintf(file, " %d:%d:%lld", node->data, node->source, now - node->dropTime);
+    }
+    fprintf(file, "\n");
+}
+
+/*  Function: readEvidence()
+    Description: Reads a "<label> <count> <type>:<source>:<age>..." record into an evidence list
+
+    in/out: FILE *file - The file to read from
+    in: const char *label - The expected record name
+    in/out: EvidenceListType *list - The list to add the evidence to
+
+    Returns: int - C_TRUE if the record was valid, C_FALSE otherwise
+*/
+static int readEvidence(FILE *file, const char *label, EvidenceListType *list) {
+    char found[MAX_STR];
+    int count;
+    if(fscanf(file, " %63s %d", found, &count) != 2 || strcmp(found, label) != 0 || count < 0) return C_FALSE;
+
+    for(int i = 0; i < count; i++) {
+        int ev, source;
+        long long age;
+        if(fscanf(file, " %d:%d:%lld", &ev, &source, &age) != 3 || ev < 0 || ev >= EV_COUNT || age < 0) return C_FALSE;
+        addSourcedEvidence(list, (EvidenceType) ev, source, -age);
+    }
+    return C_TRUE;
+}
+
+/*  Function: readName()
+    Description: Reads the rest of the current line as a name
+
+    in/out: FILE *file - The file to read from
+    out: char *name - The name, at most MAX_STR - 1 characters
+
+    Returns: int - C_TRUE if a name was read, C_FALSE otherwise
+*/
+static int readName(FILE *file, char *name) {
+    if(fscanf(file, " %63[^\n]", name) != 1) return C_FALSE;
+    return C_TRUE;
+}
+
+/*  Function: saveSnapshot()
+    Description: Pauses every thread of the game and writes the whole game state to a file.
+                 The snapshot is written to a temporary file first so a crash never leaves a partial one.
+                 Must not be called while the caller is inside gameEnter().
+
+    in: const char *path - Where to write the snapshot
+    in: HouseType *house - The house to save, including its rooms, ghosts and hunters
+
+    Returns: int - C_TRUE if the snapshot was written, C_FALSE otherwise
+*/
+int saveSnapshot(const char *path, HouseType *house) {
+    if (!path || !house) return C_FALSE; // Check for NULL pointers
+    char tmpPath[MAX_PATH + 8];
+    sprintf(tmpPath, "%s.tmp", path);
+
+    FILE *file = fopen(tmpPath, "w");
+    if(!file) return C_FALSE;
+
+    GameStateType *game = house->game;
+    pthread_rwlock_wrlock(&game->pauseLock);
+    long long now = gameTime(game);
+
+    fprintf(file, "snapshot %d\n", SNAPSHOT_VERSION);
+    fprintf(file, "game %d", isGameSolved(game));
+    for(int ev = 0; ev < EV_COUNT; ev++) fprintf(file, " %d", game->evDropped[ev]);
+    for(int ev = 0; ev < EV_COUNT; ev++) fprintf(file, " %d", game->evCollected[ev]);
+    fprintf(file, "\n");
+
+    fprintf(file, "rooms %d\n", house->roomCount);
+    for(int i = 0; i < house->roomCount; i++) {
+        RoomType *room = house->roomIndex[i];
+        fprintf(file, "room %d", room->visits);
+        for(int ev = 0; ev < EV_COUNT; ev++) fprintf(file, " %d", room->evDrops[ev]);
+        fprintf(file, " %s\n", room->name);
+
+        fprintf(file, "links %d", room->connectedRooms->size);
+        for(RoomNodeType *node = room->connectedRooms->head; node != NULL; node = node->next) {
+            fprintf(file, " %d", node->data->id);
+        }
+        fprintf(file, "\n");
+        writeEvidence(file, "evidence", room->evidenceList, now);
+    }
+    writeEvidence(file, "shared", house->evidence, now);
+
+    GhostListType *ghosts = house->ghostList;
+    fprintf(file, "ghosts %d\n", ghosts->size);
+    for(int i = 0; i < ghosts->size; i++) {
+        GhostType *ghost = ghosts->ghosts[i];
+        fprintf(file, "ghost %d %d %d %d %d %d %d %d %u\n", ghost->class, ghost->currentRoom->id, ghost->boredomTimer,
+            ghost->ticks, ghost->exited, ghost->identified, ghost->deduced, ghost->confidence, ghost->seed);
+    }
+
+    HunterListType *hunters = house->hunterList;
+    fprintf(file, "hunters %d\n", hunters->size);
+    for(int i = 0; i < hunters->size; i++) {
+        HunterType *hunter = hunters->hunters[i];
+        fprintf(file, "hunter %d %d %d %d %d %d %d %d %d %d %d %u %d %s\n", hunter->id, hunter->room->id, hunter->evidence,
+            hunter->fear, hunter->boredom, hunter->fearMax, hunter->boredomMax, hunter->ticks, hunter->sufficientEv, hunter->exitReason, hunter->policy,
+            hunter->seed, hunter->moves, hunter->name);
+
+        fprintf(file, "visited");
+        for(int r = 0; r < house->roomCount; r++) fprintf(file, " %d", hunter->visitedAt[r]);
+        fprintf(file, "\nseen");
+        for(int r = 0; r < house->roomCount; r++) fprintf(file, " %d", hunter->seenDrops[r]);
+        fprintf(file, "\n");
+    }
+
+    pthread_rwlock_unlock(&game->pauseLock);
+
+    int ok = fclose(file) == 0;
+    if(ok) ok = rename(tmpPath, path) == 0;
+    return ok;
+}
+
+/*  Function: expectLabel()
+    Description: Reads the next word and checks that it is the expected record name
+
+    in/out: FILE *file - The file to read from
+    in: const char *label - The expected record name
+
+    Returns: int - C_TRUE if the record name matched, C_FALSE otherwise
+*/
+static int expectLabel(FILE *file, const char *label) {
+    char found[MAX_STR];
+    return fscanf(file, " %63s", found) == 1 && strcmp(found, label) == 0;
+}
+
+/*  Function: loadRooms()
+    Description: Reads the room records and builds an indexed house from them
+
+    in/out: FILE *file - The file to read from
+    in/out: HouseType *house - The empty house to add the rooms to
+
+    Returns: int - C_TRUE if the rooms were valid, C_FALSE otherwise
+*/
+static int loadRooms(FILE *file, HouseType *house) {
+    int count;
+    if(!expectLabel(file, "rooms") || fscanf(file, " %d", &count) != 1 || count <= 0 || count > 0xFFFF) return C_FALSE;
+
+    // Links can point forward so every room is created before any are connected
+    RoomType **rooms = safeMalloc(sizeof(RoomType*) * count);
+    int **links = safeMalloc(sizeof(int*) * count);
+    int *linkCounts = safeMalloc(sizeof(int) * count);
+    int valid = C_TRUE;
+    int read = 0;
+
+    for(; read < count && valid; read++) {
+        char name[MAX_STR];
+        int visits;
+        int drops[EV_COUNT];
+        links[read] = NULL;
+        linkCounts[read] = 0;
+
+        valid = expectLabel(file, "room") && fscanf(file, " %d", &visits) == 1;
+        for(int ev = 0; ev < EV_COUNT && valid; ev++) valid = fscanf(file, " %d", &drops[ev]) == 1;
+        if(valid) valid = readName(file, name);
+        if(!valid) break;
+
+        rooms[read] = createRoom(name);
+        rooms[read]->visits = visits;
+        memcpy(rooms[read]->evDrops, drops, sizeof(drops));
+        addRoom(&house->rooms, rooms[read]);
+
+        valid = expectLabel(file, "links") && fscanf(file, " %d", &linkCounts[read]) == 1 && linkCounts[read] >= 0;
+        if(valid) links[read] = safeMalloc(sizeof(int) * (linkCounts[read] + 1));
+        for(int l = 0; l < linkCounts[read] && valid; l++) {
+            valid = fscanf(file, " %d", &links[read][l]) == 1 && links[read][l] >= 0 && links[read][l] < count;
+        }
+        if(valid) valid = readEvidence(file, "evidence", rooms[read]->evidenceList);
+    }
+
+    if(valid) {
+        // Each room lists all of its own neighbours so the links are added one way only
+        for(int i = 0; i < count; i++) {
+            for(int l = 0; l < linkCounts[i]; l++) {
+                addRoom(&rooms[i]->connectedRooms, rooms[links[i][l]]);
+            }
+        }
+        indexHouse(house);
+    }
+
+    for(int i = 0; i < read && i < count; i++) free(links[i]);
+    free(rooms);
+    free(links);
+    free(linkCounts);
+    return valid;
+}
+
+/*  Function: loadSnapshot()
+    Description: Rebuilds a game from a file written by saveSnapshot() and logs the restored ghosts and hunters.
+                 When config->reseed is set every entity gets a new random seed so each restored copy plays out differently.
+
+    in: const char *path - The snapshot to read
+    in: const ConfigType *config - The parameters to continue the game with
+    out: HouseType **house - Pointer to the restored house, with its ghosts and hunters
+
+    Returns: int - C_TRUE if the game was restored, C_FALSE otherwise
+*/
+int loadSnapshot(const char *path, const ConfigType *config, HouseType **house) {
+    FILE *file = fopen(path, "r");
+    if(!file) return C_FALSE;
+
+    int version;
+    int solved;
+    int valid = expectLabel(file, "snapshot") && fscanf(file, " %d", &version) == 1 && version == SNAPSHOT_VERSION &&
+        expectLabel(file, "game") && fscanf(file, " %d", &solved) == 1;
+
+    initHouse(house);
+    GameStateType *game = (*house)->game;
+    for(int ev = 0; ev < EV_COUNT && valid; ev++) valid = fscanf(file, " %d", &game->evDropped[ev]) == 1;
+    for(int ev = 0; ev < EV_COUNT && valid; ev++) valid = fscanf(file, " %d", &game->evCollected[ev]) == 1;
+    if(valid && solved) gameSolved(game);
+
+    if(valid) valid = loadRooms(file, *house);
+    if(valid) valid = readEvidence(file, "shared", (*house)->evidence);
+
+    int ghostCount = 0;
+    if(valid) valid = expectLabel(file, "ghosts") && fscanf(file, " %d", &ghostCount) == 1 && ghostCount > 0;
+    if(valid) l_gameStart();
+
+    for(int i = 0; i < ghostCount && valid; i++) {
+        int ghostClass, ghostRoom, boredom, ticks, exited, identified, deduced, confidence;
+        unsigned int seed;
+        GhostType *ghost;
+
+        valid = expectLabel(file, "ghost") && fscanf(file, " %d %d %d %d %d %d %d %d %u", &ghostClass, &ghostRoom, &boredom, &ticks,
+            &exited, &identified, &deduced, &confidence, &seed) == 9 && ghostClass >= 0 && ghostClass < GHOST_COUNT && ghostRoom >= 0 && ghostRoom < (*house)->roomCount;
+        if(!valid) break;
+
+        createGhost(*house, &ghost, ghostClass, (*house)->roomIndex[ghostRoom], config);
+        ghost->boredomTimer = boredom;
+        ghost->ticks = ticks;
+        ghost->identified = identified;
+        ghost->deduced = deduced >= 0 && deduced < GHOST_COUNT ? (GhostClass) deduced : GH_UNKNOWN;
+        ghost->confidence = confidence;
+        ghost->seed = config->reseed ? newRandomSeed() : seed;
+        if(exited) {
+            ghost->exited = C_TRUE;
+            ghostExit(ghost);
+            gameGhostLeft(game);
+        }
+        l_ghostInit(ghostClass, ghost->currentRoom->name);
+    }
+
+    int hunterCount = 0;
+    if(valid) valid = expectLabel(file, "hunters") && fscanf(file, " %d", &hunterCount) == 1 && hunterCount >= 0;
+    (*house)->hunterList = createHunterList();
+
+    for(int i = 0; i < hunterCount && valid; i++) {
+        int id, room, ev, fear, hunterBoredom, fearMax, boredomMax, hunterTicks, sufficient, reason, policy, moves;
+        unsigned int hunterSeed;
+        char name[MAX_STR];
+        HunterType *hunter;
+
+        valid = expectLabel(file, "hunter") && fscanf(file, " %d %d %d %d %d %d %d %d %d %d %d %u %d", &id, &room, &ev, &fear,
+            &hunterBoredom, &fearMax, &boredomMax, &hunterTicks, &sufficient, &reason, &policy, &hunterSeed, &moves) == 13 &&
+            readName(file, name) && fearMax > 0 && boredomMax > 0 &&
+            room >= 0 && room < (*house)->roomCount && ev >= 0 && ev < EV_COUNT && reason >= 0 && reason <= LOG_UNKNOWN &&
+            policy >= 0 && policy < MOVE_POLICY_COUNT;
+        if(!valid) break;
+
+        // initHunter puts the hunter in the van, move it to where it was
+        int hunterId = id;
+        initHunter(&hunter, (*house)->ghostList, *house, name, &id, (EvidenceType) ev, config);
+        roomRemoveHunter(hunter->room, hunter);
+        hunter->id = hunterId;
+        hunter->room = (*house)->roomIndex[room];
+        hunter->fear = fear;
+        hunter->boredom = hunterBoredom;
+        hunter->fearMax = fearMax;
+        hunter->boredomMax = boredomMax;
+        hunter->ticks = hunterTicks;
+        hunter->sufficientEv = sufficient;
+        hunter->exitReason = reason;
+        hunter->policy = policy;
+        hunter->seed = config->reseed ? newRandomSeed() : hunterSeed;
+        hunter->moves = moves;
+        addHunter((*house)->hunterList, hunter);
+
+        valid = expectLabel(file, "visited");
+        for(int r = 0; r < (*house)->roomCount && valid; r++) valid = fscanf(file, " %d", &hunter->visitedAt[r]) == 1;
+        if(valid) valid = expectLabel(file, "seen");
+        for(int r = 0; r < (*house)->roomCount && valid; r++) valid = fscanf(file, " %d", &hunter->seenDrops[r]) == 1;
+
+        // Hunters that already left are kept for the results but are not in any room
+        if(reason != LOG_UNKNOWN) {
+            gameHunterLeft(game);
+        } else {
+            roomAddHunter(hunter->room, hunter);
+        }
+    }
+
+    fclose(file);
+    if(!valid) {
+        cleanupHouse(*house);
+        return C_FALSE;
+    }
+    return C_TRUE;
+}
@@ -0,0 +1,320 @@
+#include "defs.h"
+
+#include <math.h>
+
+/*  Function: initStats()
+    Description: Initializes an empty StatsType struct
+
+    out: StatsType *stats - Pointer to the StatsType struct to initialize
+    in: FILE *csv - File to stream one row per game to, NULL to skip the CSV output
+
+    Returns: None
+*/
+void initStats(StatsType *stats, FILE *csv) {
+    memset(stats, 0, sizeof(StatsType));
+    stats->csv = csv;
+    // The room arrays are sized by the first game since the layout never changes
+    stats->roomVisits = NULL;
+    stats->roomNames = NULL;
+    stats->csvFirst = 0;
+    stats->csvStride = 1;
+}
+
+/*  Function: addRunningStat()
+    Description: Adds a value to the running count, mean and variance
+
+    in/out: RunningStatType *stat - Pointer to the RunningStatType struct to update
+    in: double value - The value to add
+
+    Returns: None
+*/
+void addRunningStat(RunningStatType *stat, double value) {
+    if(stat->count == 0 || value < stat->min) stat->min = value;
+    if(stat->count == 0 || value > stat->max) stat->max = value;
+
+    stat->count++;
+    double delta = value - stat->mean;
+    stat->mean += delta / stat->count;
+    stat->m2 += delta * (value - stat->mean);
+}
+
+/*  Function: runningStatVariance()
+    Description: Returns the sample variance of the values added so far
+
+    in: RunningStatType *stat - Pointer to the RunningStatType struct to read
+
+    Returns: double - The sample variance, 0 if there are fewer than two values
+*/
+double runningStatVariance(RunningStatType *stat) {
+    if(stat->count < 2) return 0;
+    return stat->m2 / (stat->count - 1);
+}
+
+/*  Function: addHistogram()
+    Description: Counts a value in its STAT_BIN_WIDTH wide bin
+
+    in/out: HistogramType *hist - Pointer to the HistogramType struct to update
+    in: double value - The value to count
+
+    Returns: None
+*/
+void addHistogram(HistogramType *hist, double value) {
+    int bin = value < 0 ? 0 : (int) (value / STAT_BIN_WIDTH);
+    if(bin >= STAT_BINS) {
+        hist->overflow++;
+    } else {
+        hist->bins[bin]++;
+    }
+}
+
+/*  Function: mergeRunningStat()
+    Description: Combines two running stats as if every value had been added to one of them
+
+    in/out: RunningStatType *dest - Pointer to the RunningStatType struct to add to
+    in: const RunningStatType *src - Pointer to the RunningStatType struct to add
+
+    Returns: None
+*/
+static void mergeRunningStat(RunningStatType *dest, const RunningStatType *src) {
+    if(src->count == 0) return;
+    if(dest->count == 0) {
+        *dest = *src;
+        return;
+    }
+
+    long count = dest->count + src->count;
+    double delta = src->mean - dest->mean;
+    dest->m2 += src->m2 + delta * delta * dest->count * src->count / count;
+    dest->mean += delta * src->count / count;
+    dest->count = count;
+    if(src->min < dest->min) dest->min = src->min;
+    if(src->max > dest->max) dest->max = src->max;
+}
+
+/*  Function: mergeStats()
+    Description: Adds the games aggregated in one StatsType struct to another, used to combine parallel jobs
+
+    in/out: StatsType *dest - Pointer to the StatsType struct to add to
+    in: const StatsType *src - Pointer to the StatsType struct to add
+
+    Returns: None
+*/
+void mergeStats(StatsType *dest, const StatsType *src) {
+    if (!dest || !src) return; // Check for NULL pointers
+    dest->games += src->games;
+    dest->hunterWins += src->hunterWins;
+    dest->misidentified += src->misidentified;
+    for(int c = 0; c < GHOST_COUNT; c++) {
+        dest->gamesByClass[c] += src->gamesByClass[c];
+        dest->winsByClass[c] += src->winsByClass[c];
+    }
+    for(int i = 0; i <= LOG_UNKNOWN; i++) dest->hunterExits[i] += src->hunterExits[i];
+
+    mergeRunningStat(&dest->ticks, &src->ticks);
+    for(int i = 0; i < STAT_BINS; i++) dest->tickHist.bins[i] += src->tickHist.bins[i];
+    dest->tickHist.overflow += src->tickHist.overflow;
+    for(int ev = 0; ev < EV_COUNT; ev++) {
+        mergeRunningStat(&dest->evDropped[ev], &src->evDropped[ev]);
+        mergeRunningStat(&dest->evCollected[ev], &src->evCollected[ev]);
+    }
+    mergeRunningStat(&dest->evExpired, &src->evExpired);
+    mergeRunningStat(&dest->confidence, &src->confidence);
+
+    if(!src->roomVisits) return;
+    if(!dest->roomVisits) {
+        dest->roomCount = src->roomCount;
+        dest->roomVisits = safeMalloc(sizeof(long) * src->roomCount);
+        memset(dest->roomVisits, 0, sizeof(long) * src->roomCount);
+        dest->roomNames = safeMalloc(sizeof(*dest->roomNames) * src->roomCount);
+        memcpy(dest->roomNames, src->roomNames, sizeof(*dest->roomNames) * src->roomCount);
+    }
+    for(int i = 0; i < dest->roomCount && i < src->roomCount; i++) dest->roomVisits[i] += src->roomVisits[i];
+}
+
+/*  Function: writeCsvHeader()
+    Description: Writes the column names for the rows written by recordGame()
+
+    in/out: FILE *csv - The file to write to
+
+    Returns: None
+*/
+void writeCsvHeader(FILE *csv) {
+    fprintf(csv, "game,boredom_max,fear_max,hunter_wait,ghost_wait,num_hunters,num_ghosts,ev_per_ghost,policy,hunters_won,ghost_class,ticks");
+    for(int ev = 0; ev < EV_COUNT; ev++) {
+        fprintf(csv, ",dropped_%s", evidenceName(ev));
+    }
+    for(int ev = 0; ev < EV_COUNT; ev++) {
+        fprintf(csv, ",collected_%s", evidenceName(ev));
+    }
+    fprintf(csv, ",exit_fear,exit_bored,exit_evidence\n");
+}
+
+/*  Function: recordGame()
+    Description: Adds the metrics of a finished game to the aggregate and streams a CSV row.
+                 Must be called after every thread of the game has been joined.
+
+    in/out: StatsType *stats - Pointer to the StatsType struct to add the game to
+    in: const ConfigType *config - The parameters the game was run with
+    in: HouseType *house - The house the game was played in, including the ghosts that haunted it
+
+    Returns: None
+*/
+void recordGame(StatsType *stats, const ConfigType *config, HouseType *house) {
+    if (!stats || !house) return; // Check for NULL pointers
+    GameStateType *game = house->game;
+    HunterListType *hunters = house->hunterList;
+    GhostListType *ghosts = house->ghostList;
+    int huntersWon = isGameWon(house);
+    long exits[LOG_UNKNOWN + 1] = {0};
+    int ticks = 0;
+
+    stats->games++;
+    if(huntersWon) stats->hunterWins++;
+    // A class is counted once for every ghost of that class in the game
+    for(int i = 0; i < ghosts->size; i++) {
+        stats->gamesByClass[ghosts->ghosts[i]->class]++;
+        if(huntersWon) stats->winsByClass[ghosts->ghosts[i]->class]++;
+    }
+
+    // The game lasts as long as the hunter that stayed in the house the longest
+    for(int i = 0; i < hunters->size; i++) {
+        HunterType *hunter = hunters->hunters[i];
+        if(hunter->ticks > ticks) ticks = hunter->ticks;
+        exits[hunter->exitReason]++;
+        stats->hunterExits[hunter->exitReason]++;
+    }
+    addRunningStat(&stats->ticks, ticks);
+    metricsGame(house, huntersWon, ticks);
+    addHistogram(&stats->tickHist, ticks);
+
+    for(int ev = 0; ev < EV_COUNT; ev++) {
+        addRunningStat(&stats->evDropped[ev], game->evDropped[ev]);
+        addRunningStat(&stats->evCollected[ev], game->evCollected[ev]);
+    }
+    addRunningStat(&stats->evExpired, game->evExpired);
+
+    // Only ghosts the hunters settled on count towards the deduction figures
+    for(int i = 0; i < ghosts->size; i++) {
+        GhostType *ghost = ghosts->ghosts[i];
+        if(!ghost->identified) continue;
+        addRunningStat(&stats->confidence, ghost->confidence);
+        if(ghost->deduced != ghost->class) stats->misidentified++;
+    }
+
+    if(!stats->roomVisits) {
+        stats->roomCount = house->roomCount;
+        stats->roomVisits = safeMalloc(sizeof(long) * house->roomCount);
+        memset(stats->roomVisits, 0, sizeof(long) * house->roomCount);
+        stats->roomNames = safeMalloc(sizeof(*stats->roomNames) * house->roomCount);
+        for(int i = 0; i < house->roomCount; i++) {
+            strcpy(stats->roomNames[i], house->roomIndex[i]->name);
+        }
+    }
+    for(int i = 0; i < stats->roomCount && i < house->roomCount; i++) {
+        stats->roomVisits[i] += house->roomIndex[i]->visits;
+    }
+
+    if(stats->csv) {
+        const char *policies[] = { "random", "explore", "evidence" };
+
+        // Parallel jobs share the file, the row is written under its lock so rows never interleave
+        flockfile(stats->csv);
+        fprintf(stats->csv, "%ld,%d,%d,%d,%d,%d,%d,%d,%s,%d,", stats->csvFirst + (stats->games - 1) * stats->csvStride + 1, config->boredomMax, config->fearMax,
+            config->hunterWait, config->ghostWait, config->numHunters, ghosts->size, config->evPerGhost,
+            policies[config->policy], huntersWon);
+        // Every ghost's class goes in the one column, separated by '|'
+        for(int i = 0; i < ghosts->size; i++) {
+            fprintf(stats->csv, "%s%s", i > 0 ? "|" : "", ghostName(ghosts->ghosts[i]->class));
+        }
+        fprintf(stats->csv, ",%d", ticks);
+        for(int ev = 0; ev < EV_COUNT; ev++) fprintf(stats->csv, ",%d", game->evDropped[ev]);
+        for(int ev = 0; ev < EV_COUNT; ev++) fprintf(stats->csv, ",%d", game->evCollected[ev]);
+        fprintf(stats->csv, ",%ld,%ld,%ld\n", exits[LOG_FEAR], exits[LOG_BORED], exits[LOG_EVIDENCE]);
+        funlockfile(stats->csv);
+    }
+}
+
+/*  Function: printRunningStat()
+    Description: Prints one row of the summary table
+
+    in/out: FILE *out - The file to print to
+    in: const char *label - The name of the row
+    in: RunningStatType *stat - The values to summarize
+
+    Returns: None
+*/
+static void printRunningStat(FILE *out, const char *label, RunningStatType *stat) {
+    fprintf(out, "%-24s %10.2f %10.2f %8.0f %8.0f\n", label, stat->mean, sqrt(runningStatVariance(stat)), stat->min, stat->max);
+}
+
+/*  Function: printStats()
+    Description: Prints the summary tables for every game recorded so far
+
+    in/out: FILE *out - The file to print to
+    in: StatsType *stats - The aggregate to print
+
+    Returns: None
+*/
+void printStats(FILE *out, StatsType *stats) {
+    if (!stats || stats->games == 0) return; // Nothing to summarize
+    char label[MAX_STR * 2];
+
+    fprintf(out, "--------------------------------\n");
+    fprintf(out, "Statistics over %ld games\n", stats->games);
+    fprintf(out, "--------------------------------\n");
+    fprintf(out, "Hunters won %ld (%.1f%%), ghost won %ld\n\n", stats->hunterWins,
+        100.0 * stats->hunterWins / stats->games, stats->games - stats->hunterWins);
+
+    fprintf(out, "%-24s %10s %10s\n", "Ghost class", "Games", "Hunter win%");
+    for(int c = 0; c < GHOST_COUNT; c++) {
+        double winRate = stats->gamesByClass[c] ? 100.0 * stats->winsByClass[c] / stats->gamesByClass[c] : 0;
+        fprintf(out, "%-24s %10ld %10.1f\n", ghostName(c), stats->gamesByClass[c], winRate);
+    }
+
+    fprintf(out, "\n%-24s %10s %10s %8s %8s\n", "Per game", "Mean", "Stddev", "Min", "Max");
+    printRunningStat(out, "Ticks", &stats->ticks);
+    for(int ev = 0; ev < EV_COUNT; ev++) {
+        sprintf(label, "%s dropped", evidenceName(ev));
+        printRunningStat(out, label, &stats->evDropped[ev]);
+    }
+    for(int ev = 0; ev < EV_COUNT; ev++) {
+        sprintf(label, "%s collected", evidenceName(ev));
+        printRunningStat(out, label, &stats->evCollected[ev]);
+    }
+    printRunningStat(out, "Evidence expired", &stats->evExpired);
+    printRunningStat(out, "Deduction confidence %", &stats->confidence);
+    fprintf(out, "%-24s %10ld\n", "Ghosts misidentified", stats->misidentified);
+
+    fprintf(out, "\nHunter exits: fear %ld, bored %ld, evidence %ld\n", stats->hunterExits[LOG_FEAR],
+        stats->hunterExits[LOG_BORED], stats->hunterExits[LOG_EVIDENCE]);
+
+    fprintf(out, "\n%-24s %10s\n", "Ticks", "Games");
+    for(int i = 0; i < STAT_BINS; i++) {
+        if(stats->tickHist.bins[i] == 0) continue;
+        sprintf(label, "%d - %d", i * STAT_BIN_WIDTH, (i + 1) * STAT_BIN_WIDTH - 1);
+        fprintf(out, "%-24s %10ld\n", label, stats->tickHist.bins[i]);
+    }
+    if(stats->tickHist.overflow > 0) {
+        sprintf(label, "%d+", STAT_BINS * STAT_BIN_WIDTH);
+        fprintf(out, "%-24s %10ld\n", label, stats->tickHist.overflow);
+    }
+
+    fprintf(out, "\n%-24s %10s\n", "Room", "Visits/game");
+    for(int i = 0; i < stats->roomCount; i++) {
+        fprintf(out, "%-24s %10.2f\n", stats->roomNames[i], (double) stats->roomVisits[i] / stats->games);
+    }
+    fprintf(out, "\n");
+}
+
+/*  Function: cleanupStats()
+    Description: Frees the memory allocated by the StatsType struct, the CSV file is left open
+
+    in/out: StatsType *stats - Pointer to the StatsType struct to clean up
+
+    Returns: None
+*/
+void cleanupStats(StatsType *stats) {
+    if (!stats) return; // Check for NULL pointer
+    free(stats->roomVisits);
+    free(stats->roomNames);
+}
@@ -0,0 +1,239 @@
+#include "defs.h"
+
+/*
+    Stress mode plays many games while a checker thread repeatedly looks at the house in the middle of
+    the game. Hunters are checked with every room semaphore held but without the pause lock, so a hunter
+    can be caught between leaving one room and entering the next. Moving hunters are held there for a
+    moment so that happens often. Ghosts move without the room semaphores and are checked under the
+    pause lock instead. Once the game is over every room has to be empty.
+*/
+
+// How long a hunter is held between two rooms in a stress run, a few checker passes
+#define STRESS_TRANSIT_USEC     200
+
+// Totals over every game of a stress run, only changed by checker threads
+static long stressChecks = 0;
+static long stressInFlight = 0;
+static long stressErrors = 0;
+
+/*  Function: reportError()
+    Description: Counts a broken invariant and prints the first few
+
+    in: const char *message - What was wrong
+    in: const char *name - The hunter or room it was found on
+
+    Returns: None
+*/
+static void reportError(const char *message, const char *name) {
+    long errors = __atomic_add_fetch(&stressErrors, 1, __ATOMIC_RELAXED);
+    if(errors <= 10) printf("[STRESS] %s: %s\n", message, name);
+}
+
+/*  Function: compareRoomSems()
+    Description: Orders rooms by the address of their semaphore for qsort, the same order lockSemaphors uses
+
+    in: const void *a - Pointer to the first RoomType pointer
+    in: const void *b - Pointer to the second RoomType pointer
+
+    Returns: int - Negative, zero or positive like strcmp
+*/
+static int compareRoomSems(const void *a, const void *b) {
+    const sem_t *first = &(*(RoomType* const*) a)->roomSem;
+    const sem_t *second = &(*(RoomType* const*) b)->roomSem;
+    return (first > second) - (first < second);
+}
+
+/*  Function: checkHunters()
+    Description: Checks that every hunter is listed in exactly one room or is marked as moving between two,
+                 and that the rooms count as many hunters as are inside. The caller must hold every room's semaphore.
+
+    in: HouseType *house - The house to check
+    in: int over - C_TRUE once the game has ended and no hunter may be left inside
+
+    Returns: None
+*/
+static void checkHunters(HouseType *house, int over) {
+    HunterListType *hunters = house->hunterList;
+    int counted = 0;
+    int inside = 0;
+
+    // Every listed hunter has to be in that room and at that slot, so nobody is listed twice
+    for(int r = 0; r < house->roomCount; r++) {
+        RoomType *room = house->roomIndex[r];
+        int count = __atomic_load_n(&room->hunterCount, __ATOMIC_SEQ_CST);
+        if(room->hunterList->size != count) {
+            reportError("hunter count does not match the hunters listed in room", room->name);
+        }
+        counted += count;
+        for(int slot = 0; slot < room->hunterList->size; slot++) {
+            HunterType *hunter = room->hunterList->hunters[slot];
+            if(hunter->room != room || hunter->roomSlot != slot) reportError("hunter is listed in a room it is not in", hunter->name);
+        }
+    }
+
+    // Every hunter is listed where it thinks it is, on its way to another room, or gone.
+    // A hunter is only taken out of its room after its exit reason is set, so an unlisted hunter's reason is safe to read.
+    for(int i = 0; i < hunters->size; i++) {
+        HunterType *hunter = hunters->hunters[i];
+        if(hunter->roomSlot >= 0) {
+            HunterListType *list = hunter->room->hunterList;
+            if(hunter->moving) reportError("hunter is listed in a room while moving", hunter->name);
+            if(hunter->roomSlot >= list->size || list->hunters[hunter->roomSlot] != hunter) {
+                reportError("hunter is missing from its room", hunter->name);
+            }
+            inside++;
+        } else if(hunter->moving) {
+            __atomic_add_fetch(&stressInFlight, 1, __ATOMIC_RELAXED);
+        } else if(hunter->exitReason == LOG_UNKNOWN) {
+            reportError("hunter is in no room and not moving", hunter->name);
+        }
+    }
+
+    if(counted != inside) reportError("rooms do not count every hunter inside", house->roomIndex[0]->name);
+    if(over && inside > 0) reportError("hunters are still listed after the game", house->roomIndex[0]->name);
+}
+
+/*  Function: checkGhosts()
+    Description: Checks that each room counts exactly the ghosts standing in it, the caller must have
+                 stopped every game thread with the pause lock
+
+    in: HouseType *house - The house to check
+
+    Returns: None
+*/
+static void checkGhosts(HouseType *house) {
+    GhostListType *ghosts = house->ghostList;
+    int *ghostsIn = safeMalloc(sizeof(int) * house->roomCount);
+    for(int i = 0; i < house->roomCount; i++) ghostsIn[i] = 0;
+
+    for(int i = 0; i < ghosts->size; i++) {
+        if(!ghosts->ghosts[i]->exited) ghostsIn[ghosts->ghosts[i]->currentRoom->id]++;
+    }
+    for(int r = 0; r < house->roomCount; r++) {
+        RoomType *room = house->roomIndex[r];
+        if(ghostsIn[r] != __atomic_load_n(&room->ghostCount, __ATOMIC_SEQ_CST)) {
+            reportError("ghost count does not match the ghosts in room", room->name);
+        }
+    }
+
+    free(ghostsIn);
+}
+
+/*  Function: checkOccupancy()
+    Description: Checks the hunters with every room locked, then the ghosts with the game paused
+
+    in: HouseType *house - The house to check
+    in: RoomType **rooms - The house's rooms in locking order
+    in: int over - C_TRUE once the game has ended
+
+    Returns: None
+*/
+static void checkOccupancy(HouseType *house, RoomType **rooms, int over) {
+    GameStateType *game = house->game;
+
+    for(int r = 0; r < house->roomCount; r++) sem_wait(&rooms[r]->roomSem);
+    checkHunters(house, over);
+    for(int r = 0; r < house->roomCount; r++) sem_post(&rooms[r]->roomSem);
+
+    pthread_rwlock_wrlock(&game->pauseLock);
+    checkGhosts(house);
+    pthread_rwlock_unlock(&game->pauseLock);
+
+    __atomic_add_fetch(&stressChecks, 1, __ATOMIC_RELAXED);
+}
+
+/*  Function: occupancyChecker()
+    Description: The main logic for the checker thread, checks the house during the game until
+                 every hunter and ghost has left and once more after that
+
+    in: void *housePtr - Pointer to the HouseType struct to check
+
+    Returns: void* - NULL
+*/
+static void *occupancyChecker(void *housePtr) {
+    HouseType *house = (HouseType*) housePtr;
+    GameStateType *game = house->game;
+
+    // Rooms are locked in address order so the checker cannot deadlock with a hunter holding two semaphores
+    RoomType **rooms = safeMalloc(sizeof(RoomType*) * house->roomCount);
+    for(int r = 0; r < house->roomCount; r++) rooms[r] = house->roomIndex[r];
+    qsort(rooms, house->roomCount, sizeof(RoomType*), compareRoomSems);
+
+    while(__atomic_load_n(&game->huntersActive, __ATOMIC_SEQ_CST) + __atomic_load_n(&game->ghostsActive, __ATOMIC_SEQ_CST) > 0) {
+        checkOccupancy(house, rooms, C_FALSE);
+        usleep(100);
+    }
+
+    checkOccupancy(house, rooms, C_TRUE);
+    free(rooms);
+    return NULL;
+}
+
+/*  Function: stressInTransit()
+    Description: Holds a hunter that has left its room before it enters the next. Moving only takes
+                 a moment, so without this the checker would almost never see a hunter between rooms.
+
+    in: None
+
+    Returns: None
+*/
+void stressInTransit() {
+    usleep(STRESS_TRANSIT_USEC);
+}
+
+/*  Function: startOccupancyCheck()
+    Description: Starts a checker thread on a game that is about to be played
+
+    in: HouseType *house - The house of the game
+
+    Returns: pthread_t* - Pointer to the checker thread
+*/
+pthread_t* startOccupancyCheck(HouseType *house) {
+    pthread_t *thread = safeMalloc(sizeof(pthread_t));
+    pthread_create(thread, NULL, occupancyChecker, house);
+    return thread;
+}
+
+/*  Function: stopOccupancyCheck()
+    Description: Waits for a checker thread to finish its last check after the game ended
+
+    in/out: pthread_t *thread - The checker thread, NULL if there is none
+
+    Returns: None
+*/
+void stopOccupancyCheck(pthread_t *thread) {
+    if (!thread) return; // No check was running
+    pthread_join(*thread, NULL);
+    free(thread);
+}
+
+/*  Function: runStress()
+    Description: Plays config->stress games with logging off and the occupancy checker running,
+                 then prints how many checks were made and how many of them failed. A run in which no hunter
+                 was ever seen between rooms fails as well.
+
+    in: const ConfigType *base - The parameters to play the games with
+
+    Returns: int - C_TRUE if every check passed, C_FALSE otherwise
+*/
+int runStress(const ConfigType *base) {
+    ConfigType config = *base;
+    config.prompt = C_FALSE;
+    l_setLogging(C_FALSE);
+
+    StatsType stats;
+    initStats(&stats, NULL);
+    for(int game = 0; game < config.stress; game++) {
+        runGame(&config, &stats);
+    }
+
+    printf("[STRESS] %ld games, %ld checks, %ld hunters caught moving, %ld errors\n", stats.games, stressChecks, stressInFlight, stressErrors);
+    // A run that never saw a hunter between rooms did not check the window it is for
+    if(stats.games > 0 && stressInFlight == 0) {
+        printf("[STRESS] the checker never saw a hunter between rooms\n");
+        stressErrors++;
+    }
+    if(config.stats) printStats(stdout, &stats);
+    cleanupStats(&stats);
+    return stressErrors == 0;
+}
@@ -8,7 +8,9 @@
 */
 int randInt(int min, int max)
 {
-    return (int) randFloat(min, max);
+    // The float draw can round up to max itself, which would index past the end of a list
+    int r = (int) randFloat(min, max);
+    return r < max ? r : (max > min ? max - 1 : min);
 }
 
 /*
@@ -18,18 +20,37 @@ int randInt(int min, int max)
         in:   upper end of the range of the generated number
     return:   randomly generated floating point number in the range [min, max)
 */
+static __thread unsigned int *seedPtr = NULL;
+
 float randFloat(float min, float max) {
     static __thread unsigned int seed = 0;
-    if (seed == 0) {
+    if (!seedPtr) {
         seed = (unsigned int)time(NULL) ^ (unsigned int)pthread_self();
+        seedPtr = &seed;
     }
 
-    float random = ((float) rand_r(&seed)) / (float) RAND_MAX;
+    float random = ((float) rand_r(seedPtr)) / (float) RAND_MAX;
     float diff = max - min;
     float r = random * diff;
     return min + r;
 }
 
+/*
+    Makes the calling thread draw its random numbers from the given seed, so an entity's
+    random state lives in its own struct and can be saved in a snapshot.
+        in/out: seed - the seed to use, it is updated on every draw
+*/
+void useRandomSeed(unsigned int *seed) {
+    seedPtr = seed;
+}
+
+/*
+    Returns a new non-zero seed for an entity, drawn from the calling thread's random state.
+*/
+unsigned int newRandomSeed() {
+    return ((unsigned int) randInt(0, RAND_MAX) << 1) | 1;
+}
+
 /* 
     Returns a random enum GhostClass.
 */
@@ -37,54 +58,102 @@ enum GhostClass randomGhost() {
     return (enum GhostClass) randInt(0, GHOST_COUNT);
 }
 
+// Tables generated from GHOST_CLASSES, indexed by GhostClass
+#define GHOST_CLASS_NAME(cls, name, evidence) name,
+#define GHOST_CLASS_EVIDENCE(cls, name, evidence) evidence,
+#define GHOST_CLASS_BY_EVIDENCE(cls, name, evidence) [evidence] = cls + 1,
+static const char *ghostNames[GHOST_COUNT] = { GHOST_CLASSES(GHOST_CLASS_NAME) };
+static const int ghostEvidenceMasks[GHOST_COUNT] = { GHOST_CLASSES(GHOST_CLASS_EVIDENCE) };
+// Indexed by evidence mask and offset by one so masks no class leaves stay 0. Two classes leaving
+// the same evidence initialize the same entry twice, which the Makefile's -Werror=override-init refuses to compile
+static const unsigned char ghostsByEvidence[EV_BIT(EV_COUNT)] = { GHOST_CLASSES(GHOST_CLASS_BY_EVIDENCE) };
+
+// Indexed by EvidenceType
+static const char *evidenceNames[EV_COUNT] = { "EMF", "TEMPERATURE", "FINGERPRINTS", "SOUND" };
+
 /*
-    Returns the string representation of the given enum EvidenceType.
-        in: type - the enum EvidenceType to convert
-        out: str - the string representation of the given enum EvidenceType, minimum 16 characters
-*/
-void evidenceToString(enum EvidenceType type, char* str) {
-    switch (type) {
-        case EMF:
-            strcpy(str, "EMF");
-            break;
-        case TEMPERATURE:
-            strcpy(str, "TEMPERATURE");
-            break;
-        case FINGERPRINTS:
-            strcpy(str, "FINGERPRINTS");
-            break;
-        case SOUND:
-            strcpy(str, "SOUND");
-            break;
-        default:
-            strcpy(str, "UNKNOWN");
-            break;
-    }
+    Returns the name of the given enum EvidenceType.
+        in: type - the enum EvidenceType to name
+    return: the name, "UNKNOWN" for anything that is not an evidence type
+*/
+const char* evidenceName(enum EvidenceType type) {
+    return type >= 0 && type < EV_COUNT ? evidenceNames[type] : "UNKNOWN";
 }
 
 /* 
-    Returns the string representation of the given enum GhostClass.
-        in: ghost - the enum GhostClass to convert
-        out: buffer - the string representation of the given enum GhostClass, minimum 16 characters
-*/
-void ghostToString(enum GhostClass ghost, char* buffer) {
-    switch(ghost) {
-        case BANSHEE:
-            strcpy(buffer, "Banshee");
-            break;
-        case BULLIES:
-            strcpy(buffer, "Bullies");
-            break;
-        case PHANTOM:
-            strcpy(buffer, "Phantom");
-            break;
-        case POLTERGEIST:
-            strcpy(buffer, "Poltergeist");
-            break;
-        default:
-            strcpy(buffer, "Unknown");
-            break;
+    Returns the name of the given enum GhostClass.
+        in: ghost - the enum GhostClass to name
+    return: the name, "Unknown" for anything that is not a ghost class
+*/
+const char* ghostName(enum GhostClass ghost) {
+    return ghost >= 0 && ghost < GHOST_COUNT ? ghostNames[ghost] : "Unknown";
+}
+
+/*
+    Returns the evidence the given enum GhostClass leaves.
+        in: ghost - the enum GhostClass
+    return: a mask with EV_BIT() set for every evidence type, 0 for anything that is not a ghost class
+*/
+int ghostEvidence(enum GhostClass ghost) {
+    return ghost >= 0 && ghost < GHOST_COUNT ? ghostEvidenceMasks[ghost] : 0;
+}
+
+/*
+    Returns the ghost class that leaves exactly the given evidence.
+        in: evidence - a mask of EV_BIT()s
+    return: the matching enum GhostClass, GH_UNKNOWN if no class leaves that evidence
+*/
+enum GhostClass ghostFromEvidence(int evidence) {
+    if (evidence < 0 || evidence >= EV_BIT(EV_COUNT) || ghostsByEvidence[evidence] == 0) return GH_UNKNOWN;
+    return (enum GhostClass) (ghostsByEvidence[evidence] - 1);
+}
+
+/*
+    Works out which ghost class left the evidence found so far. Every class that leaves all of the
+    found evidence is a candidate and they are taken to be equally likely, so one is picked at random
+    with the calling thread's seed, or the first one is taken when no random draw may be made.
+    Without any evidence nothing is deduced, however low the confidence asked for is.
+        in: found - a mask of EV_BIT()s
+        out: confidence - how likely the returned class is in percent, 0 if there is no candidate
+        in: randomTies - C_TRUE to pick among the candidates at random, C_FALSE to take the first
+    return: one of the candidates, GH_UNKNOWN if nothing was found or no class leaves all of the evidence
+*/
+enum GhostClass deduceGhost(int found, int *confidence, int randomTies) {
+    enum GhostClass best = GH_UNKNOWN;
+    int candidates = 0;
+    if (found == 0) {
+        *confidence = 0;
+        return GH_UNKNOWN;
+    }
+    for (int c = 0; c < GHOST_COUNT; c++) {
+        if ((ghostEvidenceMasks[c] & found) != found) continue;
+        // Keeping the n-th candidate with a chance of 1/n leaves every candidate as likely as the others
+        candidates++;
+        if (candidates == 1 || (randomTies && randInt(0, candidates) == 0)) best = (enum GhostClass) c;
     }
+    *confidence = candidates > 0 ? 100 / candidates : 0;
+    return best;
+}
+
+/*
+    Returns the number of bits set in a mask.
+        in: mask - the mask to count
+    return: the number of set bits
+*/
+int countBits(int mask) {
+    return __builtin_popcount((unsigned int) mask);
+}
+
+/*
+    Returns the hunter movement policy with the given name.
+        in: name - "random", "explore" or "evidence"
+    return: the matching enum MovePolicy, MOVE_POLICY_COUNT if the name is not recognized
+*/
+MovePolicyType policyFromString(const char *name) {
+    if (strcmp(name, "random") == 0) return MOVE_RANDOM;
+    if (strcmp(name, "explore") == 0) return MOVE_EXPLORE;
+    if (strcmp(name, "evidence") == 0) return MOVE_EVIDENCE;
+    return MOVE_POLICY_COUNT;
 }
 
 /*  Function: safeMalloc()
@@ -104,6 +173,28 @@ void* safeMalloc(size_t size) {
     return ptr;
 }
 
+/*  Function: waitSemaphor()
+    Description: Locks a semaphor, the time spent waiting for it is profiled. When metrics are on, waits on
+                 a semaphor that is already taken are also timed, a free one is taken in a single try.
+
+    in/out: sem_t *sem - Pointer to the semaphor to lock
+    
+    Returns: None
+*/
+void waitSemaphor(sem_t *sem) {
+    PROFILE_BEGIN(PROF_LOCK);
+    if(!metricsEnabled()) {
+        sem_wait(sem);
+    } else if(sem_trywait(sem) != 0) {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        sem_wait(sem);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        metricsLockWait((end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec));
+    }
+    PROFILE_END();
+}
+
 /*  Function: lockSemaphors()
     Description: Locks two semaphors in the correct order
 
@@ -114,11 +205,11 @@ void* safeMalloc(size_t size) {
 */
 void lockSemaphors(sem_t *first, sem_t *second) {
     if (first < second) {
-        sem_wait(first);
-        sem_wait(second);
+        waitSemaphor(first);
+        waitSemaphor(second);
     } else {
-        sem_wait(second);
-        sem_wait(first);
+        waitSemaphor(second);
+        waitSemaphor(first);
     }
 }
 
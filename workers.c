@@ -0,0 +1,277 @@
+#include "defs.h"
+
+/*
+    Worker mode runs a game on a fixed number of threads instead of one thread per entity. The rooms
+    are split into connected regions and each worker steps the hunters and ghosts standing in its
+    region, so the rooms a worker locks are almost always only locked by that worker. An entity that
+    moves into another region is handed to that region's worker at the end of the round.
+*/
+
+/*  Function: pushWorkItem()
+    Description: Adds a work item to the end of an array, growing it when it is full
+
+    in/out: WorkItemType **items - Pointer to the array
+    in/out: int *size - Pointer to the number of items in the array
+    in/out: int *capacity - Pointer to the number of items the array can hold
+    in: WorkItemType item - The item to add
+
+    Returns: None
+*/
+static void pushWorkItem(WorkItemType **items, int *size, int *capacity, WorkItemType item) {
+    // Double the array when it is full
+    if (*size == *capacity) {
+        *capacity = *capacity > 0 ? *capacity * 2 : NUM_HUNTERS;
+        *items = realloc(*items, sizeof(WorkItemType) * *capacity);
+        if (!*items) {
+            printf("Out of memory.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    (*items)[*size] = item;
+    (*size)++;
+}
+
+/*  Function: itemRegion()
+    Description: Finds the region of the room a hunter or ghost is standing in
+
+    in: PartitionType *partition - The partitioned house
+    in: WorkItemType *item - The hunter or ghost
+
+    Returns: int - The id of the worker that owns the room
+*/
+static int itemRegion(PartitionType *partition, WorkItemType *item) {
+    RoomType *room = item->hunter ? item->hunter->room : item->ghost->currentRoom;
+    return partition->roomRegion[room->id];
+}
+
+/*  Function: stepItem()
+    Description: Gives a hunter or ghost its turn and schedules the next one
+
+    in/out: WorkItemType *item - The hunter or ghost to step
+
+    Returns: int - C_FALSE if the entity left the house, C_TRUE otherwise
+*/
+static int stepItem(WorkItemType *item) {
+    if(item->hunter) {
+        HunterType *hunter = item->hunter;
+        useRandomSeed(&hunter->seed);
+        if(!hunterActive(hunter) || !hunterStep(hunter)) {
+            hunterFinish(hunter);
+            return C_FALSE;
+        }
+        item->due += hunter->config->hunterWait;
+    } else {
+        GhostType *ghost = item->ghost;
+        useRandomSeed(&ghost->seed);
+        if(!ghostActive(ghost)) {
+            ghostFinish(ghost);
+            return C_FALSE;
+        }
+        ghostStep(ghost);
+        item->due += ghost->config->ghostWait;
+    }
+    return C_TRUE;
+}
+
+/*  Function: advanceRound()
+    Description: Moves game time to the earliest due entity, called by one worker while the others
+                 wait at the end of the round
+
+    in/out: PartitionType *partition - The partitioned house
+
+    Returns: None
+*/
+static void advanceRound(PartitionType *partition) {
+    long long next = LLONG_MAX;
+    for(int i = 0; i < partition->workerCount; i++) {
+        if(partition->workers[i].nextDue < next) next = partition->workers[i].nextDue;
+    }
+
+    // Nothing is due anywhere once every hunter and ghost has left
+    partition->done = next == LLONG_MAX;
+    if(!partition->done) {
+        partition->now = next;
+        __atomic_store_n(&partition->house->game->clockNow, next, __ATOMIC_RELAXED);
+    }
+}
+
+/*  Function: workerLogic()
+    Description: The main logic for a worker thread. Each round the worker steps its due entities and
+                 sends the ones that left its region away, then takes in the ones sent to it.
+
+    in/out: void *workerPtr - Pointer to the WorkerType struct to run
+    
+    Returns: void* - NULL
+*/
+static void *workerLogic(void *workerPtr) {
+    WorkerType *worker = (WorkerType*) workerPtr;
+    PartitionType *partition = worker->partition;
+    PROFILE_THREAD_START();
+
+    while(!partition->done) {
+        worker->nextDue = LLONG_MAX;
+        int kept = 0;
+
+        for(int i = 0; i < worker->size; i++) {
+            WorkItemType item = worker->items[i];
+            if(item.due <= partition->now && !stepItem(&item)) continue;
+            if(item.due < worker->nextDue) worker->nextDue = item.due;
+
+            int region = itemRegion(partition, &item);
+            if(region == worker->id) {
+                worker->items[kept++] = item;
+                continue;
+            }
+
+            // The entity moved into another region, its owner picks it up after the round
+            WorkerType *owner = &partition->workers[region];
+            pthread_mutex_lock(&owner->inboxLock);
+            pushWorkItem(&owner->inbox, &owner->inboxSize, &owner->inboxCapacity, item);
+            pthread_mutex_unlock(&owner->inboxLock);
+        }
+        worker->size = kept;
+
+        // Nothing is sent between the two barriers so the inbox can be emptied without racing a sender
+        if(pthread_barrier_wait(&partition->roundEnd) == PTHREAD_BARRIER_SERIAL_THREAD) advanceRound(partition);
+        for(int i = 0; i < worker->inboxSize; i++) {
+            pushWorkItem(&worker->items, &worker->size, &worker->capacity, worker->inbox[i]);
+        }
+        worker->inboxSize = 0;
+        pthread_barrier_wait(&partition->roundStart);
+    }
+
+    PROFILE_THREAD_DONE();
+    return NULL;
+}
+
+/*  Function: partitionHouse()
+    Description: Splits the rooms into connected regions of about the same size by cutting a breadth
+                 first walk from the van into equal runs
+
+    out: PartitionType *partition - The partition to fill
+    in: HouseType *house - The indexed house to split
+    in: int workers - The number of regions wanted, at most one per room is made
+
+    Returns: None
+*/
+void partitionHouse(PartitionType *partition, HouseType *house, int workers) {
+    int roomCount = house->roomCount;
+    partition->house = house;
+    partition->workerCount = workers < roomCount ? workers : roomCount;
+    partition->roomRegion = safeMalloc(sizeof(int) * roomCount);
+    partition->now = 0;
+    partition->done = C_FALSE;
+
+    // Walk the house breadth first, the queue doubles as the visiting order
+    RoomType **queue = safeMalloc(sizeof(RoomType*) * roomCount);
+    for(int i = 0; i < roomCount; i++) partition->roomRegion[i] = -1;
+    int head = 0, tail = 0;
+    queue[tail++] = house->roomIndex[0];
+    partition->roomRegion[0] = 0;
+    while(head < tail) {
+        RoomType *room = queue[head++];
+        for(RoomNodeType *node = room->connectedRooms->head; node != NULL; node = node->next) {
+            if(partition->roomRegion[node->data->id] != -1) continue;
+            partition->roomRegion[node->data->id] = 0;
+            queue[tail++] = node->data;
+        }
+    }
+
+    // Rooms that can not be reached from the van go at the end
+    for(int i = 0; i < roomCount; i++) {
+        if(partition->roomRegion[i] == -1) queue[tail++] = house->roomIndex[i];
+    }
+    for(int i = 0; i < roomCount; i++) {
+        partition->roomRegion[queue[i]->id] = (int) ((long) i * partition->workerCount / roomCount);
+    }
+    free(queue);
+
+    partition->workers = safeMalloc(sizeof(WorkerType) * partition->workerCount);
+    for(int i = 0; i < partition->workerCount; i++) {
+        WorkerType *worker = &partition->workers[i];
+        worker->id = i;
+        worker->partition = partition;
+        worker->items = NULL;
+        worker->size = 0;
+        worker->capacity = 0;
+        worker->inbox = NULL;
+        worker->inboxSize = 0;
+        worker->inboxCapacity = 0;
+        pthread_mutex_init(&worker->inboxLock, NULL);
+        worker->nextDue = LLONG_MAX;
+    }
+    pthread_barrier_init(&partition->roundEnd, NULL, partition->workerCount);
+    pthread_barrier_init(&partition->roundStart, NULL, partition->workerCount);
+}
+
+/*  Function: runPartitioned()
+    Description: Runs a game on a fixed number of worker threads, each owning a region of the house,
+                 and waits for every hunter and ghost to leave. Game time is kept by the workers.
+
+    in/out: HouseType *house - The house the game is played in
+    in: int workers - The number of worker threads
+
+    Returns: None
+*/
+void runPartitioned(HouseType *house, int workers) {
+    PartitionType partition;
+    partitionHouse(&partition, house, workers);
+
+    // Hand every entity that is still in the house to the owner of its room, each acts after its first wait
+    GhostListType *ghostList = house->ghostList;
+    HunterListType *hunterList = house->hunterList;
+    long long first = LLONG_MAX;
+    for(int i = 0; i < ghostList->size; i++) {
+        if(ghostList->ghosts[i]->exited) continue;
+        WorkItemType item = { NULL, ghostList->ghosts[i], ghostList->ghosts[i]->config->ghostWait };
+        WorkerType *owner = &partition.workers[itemRegion(&partition, &item)];
+        pushWorkItem(&owner->items, &owner->size, &owner->capacity, item);
+        if(item.due < first) first = item.due;
+    }
+    for(int i = 0; i < hunterList->size; i++) {
+        if(hunterList->hunters[i]->exitReason != LOG_UNKNOWN) continue;
+        WorkItemType item = { hunterList->hunters[i], NULL, hunterList->hunters[i]->config->hunterWait };
+        WorkerType *owner = &partition.workers[itemRegion(&partition, &item)];
+        pushWorkItem(&owner->items, &owner->size, &owner->capacity, item);
+        if(item.due < first) first = item.due;
+    }
+
+    house->game->clockNow = 0;
+    house->game->startTime = 0;
+    partition.done = first == LLONG_MAX;
+    if(!partition.done) {
+        partition.now = first;
+        house->game->clockNow = first;
+    }
+
+    pthread_t *threads = safeMalloc(sizeof(pthread_t) * partition.workerCount);
+    for(int i = 0; i < partition.workerCount; i++) {
+        pthread_create(&threads[i], NULL, workerLogic, &partition.workers[i]);
+    }
+    for(int i = 0; i < partition.workerCount; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    free(threads);
+    cleanupPartition(&partition);
+}
+
+/*  Function: cleanupPartition()
+    Description: Frees all dynamically allocated memory in the PartitionType struct, the struct itself is not freed
+
+    in/out: PartitionType *partition - Pointer to the PartitionType struct to clean up
+
+    Returns: None
+*/
+void cleanupPartition(PartitionType *partition) {
+    if (!partition) return; // Check for NULL pointer
+    for(int i = 0; i < partition->workerCount; i++) {
+        free(partition->workers[i].items);
+        free(partition->workers[i].inbox);
+        pthread_mutex_destroy(&partition->workers[i].inboxLock);
+    }
+    free(partition->workers);
+    free(partition->roomRegion);
+    pthread_barrier_destroy(&partition->roundEnd);
+    pthread_barrier_destroy(&partition->roundStart);
+}